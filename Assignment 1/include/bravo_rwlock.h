@@ -0,0 +1,45 @@
+/* File:     bravo_rwlock.h
+ * Purpose:  Header file for bravo_rwlock.c, a reader-biased distributed
+ *           reader-writer lock layered on my_rwlock_t.
+ *
+ * Notes:
+ * 1.  While the lock is read-biased, a reader only marks its own
+ *     cache-line padded slot and never touches the shared lock.  A writer
+ *     revokes the bias and waits for the marked slots to clear; readers
+ *     then use the underlying my_rwlock_t, which decides the READ_PRIORITY
+ *     / WRITE_PRIORITY fairness as before.
+ * 2.  Threads are identified by rank, 0 ... thread_count-1, and each rank
+ *     must be used by one thread at a time.  A reader unlocks with
+ *     bravo_rdunlock, a writer with bravo_wrunlock.
+ */
+#ifndef _BRAVO_RWLOCK_H_
+#define _BRAVO_RWLOCK_H_
+
+#include <stdatomic.h>
+
+#include "my_rwlock.h"
+
+#define BRAVO_CACHE_LINE 64
+
+typedef struct {
+  _Atomic int reading; /* 1 while its rank holds a fast-path read lock */
+} __attribute__((aligned(BRAVO_CACHE_LINE))) bravo_slot_t;
+
+typedef struct {
+  _Atomic int read_bias __attribute__((aligned(BRAVO_CACHE_LINE)));
+  _Atomic int writers;        /* Writers inside wrlock ... wrunlock */
+  long long inhibit_until_ns; /* Bias stays off until then */
+  my_rwlock_t underlying;
+  int thread_count;
+  bravo_slot_t* slots; /* One per rank */
+} bravo_rwlock_t;
+
+int bravo_rwlock_init(bravo_rwlock_t* lock, int priority_mode,
+                      int thread_count);
+void bravo_rwlock_destroy(bravo_rwlock_t* lock);
+void bravo_rdlock(bravo_rwlock_t* lock, long rank);
+void bravo_rdunlock(bravo_rwlock_t* lock, long rank);
+void bravo_wrlock(bravo_rwlock_t* lock);
+void bravo_wrunlock(bravo_rwlock_t* lock);
+
+#endif
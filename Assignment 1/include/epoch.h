@@ -0,0 +1,48 @@
+/* File:     epoch.h
+ * Purpose:  Header file for epoch.c, epoch-based memory reclamation for
+ *           lock-free data structures.
+ *
+ * Notes:
+ * 1.  A thread brackets every operation on the structure with
+ *     epoch_enter / epoch_exit.  Memory it unlinks is handed to
+ *     epoch_retire instead of free, and is freed once no thread can still
+ *     be inside an operation that started before the unlink.
+ * 2.  Threads are identified by rank, 0 ... thread_count-1, and each rank
+ *     must be used by one thread at a time.
+ */
+#ifndef _EPOCH_H_
+#define _EPOCH_H_
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define EPOCH_CACHE_LINE 64
+
+/* Memory retired in one epoch by one thread */
+typedef struct {
+  void** items;
+  size_t count;
+  size_t capacity;
+  unsigned long epoch; /* Epoch the items were retired in */
+} epoch_limbo_t;
+
+typedef struct {
+  _Atomic unsigned long state; /* (epoch << 1) | 1 while inside, else 0 */
+  epoch_limbo_t limbo[3];      /* Indexed by epoch % 3 */
+  int retired_since_advance;
+} __attribute__((aligned(EPOCH_CACHE_LINE))) epoch_slot_t;
+
+typedef struct {
+  _Atomic unsigned long global __attribute__((aligned(EPOCH_CACHE_LINE)));
+  int thread_count;
+  void (*free_fn)(void*);
+  epoch_slot_t* slots;
+} epoch_t;
+
+int epoch_init(epoch_t* epoch, int thread_count, void (*free_fn)(void*));
+void epoch_destroy(epoch_t* epoch);
+void epoch_enter(epoch_t* epoch, long rank);
+void epoch_exit(epoch_t* epoch, long rank);
+void epoch_retire(epoch_t* epoch, long rank, void* item);
+
+#endif
@@ -0,0 +1,52 @@
+/* File:     flat_combining.h
+ * Purpose:  Header file for flat_combining.c, which runs the set
+ *           operations of many threads through one combiner thread at a
+ *           time (Hendler, Incze, Shavit and Tzafrir, SPAA 2010).
+ *
+ * Notes:
+ * 1.  A thread publishes its op in its own cache-line padded slot.  The
+ *     thread that wins the combiner flag gathers every published op,
+ *     hands them to apply in one call and writes back the results; the
+ *     others wait on their own slot instead of on a shared lock.
+ * 2.  apply runs with the combiner flag held, so it has the structure to
+ *     itself.  It gets the ops with index set to the publishing rank and
+ *     may reorder them, but must not change index.
+ * 3.  Threads are identified by rank, 0 ... thread_count-1, and each rank
+ *     must be used by one thread at a time.
+ */
+#ifndef _FLAT_COMBINING_H_
+#define _FLAT_COMBINING_H_
+
+#include <stdatomic.h>
+
+#include "set_backend.h"
+
+#define FC_CACHE_LINE 64
+
+typedef void (*fc_apply_fn)(void* context, set_op_t* ops, int count,
+                            long rank);
+
+typedef struct {
+  _Atomic int pending; /* 1 from publication until the result is in */
+  set_op_t op;
+} __attribute__((aligned(FC_CACHE_LINE))) fc_slot_t;
+
+typedef struct {
+  _Atomic int combiner __attribute__((aligned(FC_CACHE_LINE)));
+  int thread_count;
+  fc_slot_t* slots;  /* One per rank */
+  set_op_t* scratch; /* Ops gathered by the combiner */
+  fc_apply_fn apply;
+  void* context;
+  unsigned long long passes;   /* Combining passes, by the combiner only */
+  unsigned long long combined; /* Ops applied in them */
+} flat_combiner_t;
+
+int fc_init(flat_combiner_t* fc, int thread_count, fc_apply_fn apply,
+            void* context);
+void fc_destroy(flat_combiner_t* fc);
+int fc_execute(flat_combiner_t* fc, long rank, wl_op_t op, int key);
+int fc_execute_batch(flat_combiner_t* fc, long rank, set_op_t* ops,
+                     int count);
+
+#endif
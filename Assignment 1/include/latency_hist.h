@@ -0,0 +1,57 @@
+/* File:     latency_hist.h
+ * Purpose:  Header file for latency_hist.c, fixed-size log-linear
+ *           histograms of latencies in the style of HdrHistogram.
+ *
+ * Notes:
+ * 1.  Values below 2^LH_SUB_BITS have a bucket each; above that every
+ *     power of two is split into 2^LH_SUB_BITS buckets, so a recorded
+ *     value is known to within 1 / 2^LH_SUB_BITS (about 3%) over the
+ *     whole 64-bit range.
+ * 2.  lh_record is inline and only touches the histogram it is given:
+ *     each thread records into its own and the histograms are merged
+ *     after the threads join.
+ */
+#ifndef _LATENCY_HIST_H_
+#define _LATENCY_HIST_H_
+
+#include <stdio.h>
+#include <time.h>
+
+#define LH_SUB_BITS 5
+#define LH_SUB_COUNT (1 << LH_SUB_BITS)
+#define LH_BUCKETS ((64 - LH_SUB_BITS + 1) * LH_SUB_COUNT)
+
+typedef struct {
+  unsigned long long counts[LH_BUCKETS];
+  unsigned long long count; /* Values recorded */
+  unsigned long long max;
+  double sum;
+} lh_hist_t;
+
+void lh_init(lh_hist_t* hist);
+void lh_merge(lh_hist_t* dst, const lh_hist_t* src);
+unsigned long long lh_percentile(const lh_hist_t* hist, double percent);
+void lh_print(const lh_hist_t* hist, const char* name, FILE* stream);
+
+static inline int lh_index(unsigned long long value) {
+  if (value < LH_SUB_COUNT) return (int)value;
+  int msb = 63 - __builtin_clzll(value);
+  int shift = msb - LH_SUB_BITS;
+  return (shift + 1) * LH_SUB_COUNT +
+         (int)((value >> shift) & (LH_SUB_COUNT - 1));
+}
+
+static inline void lh_record(lh_hist_t* hist, unsigned long long value) {
+  hist->counts[lh_index(value)]++;
+  hist->count++;
+  hist->sum += value;
+  if (value > hist->max) hist->max = value;
+}
+
+static inline unsigned long long lh_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif
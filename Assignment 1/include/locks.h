@@ -0,0 +1,65 @@
+/* File:     locks.h
+ * Purpose:  Header file for locks.c, a set of mutual exclusion locks behind
+ *           one interface: pthread mutex, test-and-test-and-set spinlock
+ *           with exponential backoff, ticket lock, and the MCS and CLH
+ *           queue locks.
+ *
+ * Notes:
+ * 1.  Every thread that uses a lock needs its own lock_node_t, set up once
+ *     with lock_node_init and passed to every lock_lock / lock_unlock pair.
+ *     Only the queue locks use it, but passing it always lets callers
+ *     switch kinds without changing code.
+ * 2.  A node may be used with one lock at a time.
+ */
+#ifndef _LOCKS_H_
+#define _LOCKS_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define LOCK_CACHE_LINE 64
+
+typedef enum {
+  LOCK_MUTEX,  /* pthread_mutex_t */
+  LOCK_TTAS,   /* Test-and-test-and-set with exponential backoff */
+  LOCK_TICKET, /* FIFO ticket lock */
+  LOCK_MCS,    /* MCS queue lock: spin on the own node */
+  LOCK_CLH     /* CLH queue lock: spin on the predecessor's node */
+} lock_kind_t;
+
+/* Queue element of the CLH lock; these move between threads, so they live
+ * on the heap */
+typedef struct lock_cell {
+  _Atomic int locked;
+} __attribute__((aligned(LOCK_CACHE_LINE))) lock_cell_t;
+
+typedef struct lock_node {
+  _Atomic(struct lock_node*) next; /* MCS: successor in the queue */
+  _Atomic int locked;              /* MCS: set until the predecessor leaves */
+  lock_cell_t* cell;               /* CLH: cell to enqueue next */
+  lock_cell_t* pred;               /* CLH: predecessor's cell while held */
+} __attribute__((aligned(LOCK_CACHE_LINE))) lock_node_t;
+
+typedef struct {
+  lock_kind_t kind;
+  pthread_mutex_t mutex;
+  /* Fields written by different threads sit on their own cache lines */
+  _Atomic int flag __attribute__((aligned(LOCK_CACHE_LINE)));
+  _Atomic unsigned next_ticket __attribute__((aligned(LOCK_CACHE_LINE)));
+  _Atomic unsigned now_serving __attribute__((aligned(LOCK_CACHE_LINE)));
+  _Atomic(lock_node_t*) mcs_tail __attribute__((aligned(LOCK_CACHE_LINE)));
+  _Atomic(lock_cell_t*) clh_tail __attribute__((aligned(LOCK_CACHE_LINE)));
+} lock_t;
+
+int lock_init(lock_t* lock, lock_kind_t kind);
+void lock_destroy(lock_t* lock);
+void lock_lock(lock_t* lock, lock_node_t* node);
+void lock_unlock(lock_t* lock, lock_node_t* node);
+
+int lock_node_init(lock_node_t* node);
+void lock_node_destroy(lock_node_t* node);
+
+int lock_kind_parse(const char* name, lock_kind_t* kind_p);
+const char* lock_kind_name(lock_kind_t kind);
+
+#endif
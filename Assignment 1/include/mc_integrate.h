@@ -0,0 +1,42 @@
+/* File:     mc_integrate.h
+ * Purpose:  Header file for mc_integrate.c, a multithreaded Monte Carlo
+ *           integrator for functions over a d-dimensional box.
+ */
+#ifndef _MC_INTEGRATE_H_
+#define _MC_INTEGRATE_H_
+
+#include <stdint.h>
+
+/* Evaluates the integrand at n points; x holds the points one after the
+ * other, dim coordinates each, and the values go to values[0 ... n-1].
+ * Taking a whole batch lets the integrand loop (and vectorize) over the
+ * points instead of paying an indirect call per point. */
+typedef void (*mc_integrand_t)(const double* x, int dim, int n,
+                               double* values, void* arg);
+
+/* How the points are drawn */
+typedef enum {
+  MC_PSEUDO, /* Philox pseudo-random numbers */
+  MC_SOBOL   /* Sobol sequence, for dim <= SOBOL_MAX_DIM */
+} mc_sampler_t;
+
+typedef struct {
+  int dim;              /* Number of dimensions */
+  const double* lower;  /* Lower corner of the box, dim values */
+  const double* upper;  /* Upper corner of the box, dim values */
+  mc_integrand_t f;     /* Integrand */
+  void* arg;            /* Passed through to f */
+  mc_sampler_t sampler; /* Source of the points */
+  uint64_t seed;        /* Philox seed for MC_PSEUDO */
+} mc_problem_t;
+
+typedef struct {
+  double estimate;  /* Estimate of the integral */
+  double std_error; /* Standard error of the estimate (MC_PSEUDO) */
+  long long points; /* Points evaluated */
+} mc_result_t;
+
+int mc_integrate(const mc_problem_t* problem, int thread_count,
+                 long long points, mc_result_t* result);
+
+#endif
@@ -8,7 +8,16 @@
 #ifndef _MY_RAND_H_
 #define _MY_RAND_H_
 
+#include <stddef.h>
+
+/* Numbers in each stream returned by my_rand_stream */
+#define MR_STREAM_LENGTH 16777216ULL
+
 unsigned my_rand(unsigned* a_p);
 double my_drand(unsigned* a_p);
+unsigned my_rand_jump(unsigned seed, unsigned long long k);
+unsigned my_rand_stream(unsigned base_seed, unsigned stream_id);
+void my_rand_fill(unsigned* seed_p, unsigned* buf, size_t n);
+void my_drand_fill(unsigned* seed_p, double* buf, size_t n);
 
 #endif
@@ -0,0 +1,63 @@
+/* File:     my_rwlock.h
+ * Purpose:  Header file for my_rwlock.c, a reader-writer lock built from a
+ *           mutex and two condition variables, with a choice between
+ *           read priority and write priority.
+ *
+ * Notes:
+ * 1.  READ_PRIORITY:  readers only wait for an active writer, so a steady
+ *     stream of readers can starve the writers.
+ * 2.  WRITE_PRIORITY: readers also wait while a writer is waiting, and an
+ *     unlock wakes a waiting writer before the waiting readers.
+ * 3.  Compiled with -DINSTRUMENT the lock also collects histograms of the
+ *     time threads wait for it and hold it, and of the number of threads
+ *     already waiting when one arrives.  The hold time is kept per thread,
+ *     so a thread may only hold one my_rwlock_t at a time.
+ */
+#ifndef _MY_RWLOCK_H_
+#define _MY_RWLOCK_H_
+
+#include <pthread.h>
+
+#ifdef INSTRUMENT
+#include "latency_hist.h"
+
+/* Updated under the lock's mutex */
+typedef struct {
+  lh_hist_t read_wait;      /* ns from rdlock call to owning the lock */
+  lh_hist_t write_wait;     /* ns from wrlock call to owning the lock */
+  lh_hist_t read_hold;      /* ns from owning the lock to unlock */
+  lh_hist_t write_hold;
+  lh_hist_t readers_queued; /* Readers waiting when a thread arrives */
+  lh_hist_t writers_queued; /* Writers waiting when a thread arrives */
+} my_rwlock_stats_t;
+#endif
+
+/* Constants for priority modes */
+#define READ_PRIORITY 0
+#define WRITE_PRIORITY 1
+
+/* Custom Read-Write Lock Structure */
+typedef struct {
+  pthread_mutex_t mutex;       /* Mutex to protect the structure */
+  pthread_cond_t readers_cond; /* Condition variable for readers */
+  pthread_cond_t writers_cond; /* Condition variable for writers */
+  int active_readers;          /* Number of active readers */
+  int waiting_readers;         /* Number of readers waiting */
+  int active_writers;          /* Number of active writers (0 or 1) */
+  int waiting_writers;         /* Number of writers waiting */
+  int priority;                /* 0 for read-priority, 1 for write-priority */
+#ifdef INSTRUMENT
+  my_rwlock_stats_t stats;
+#endif
+} my_rwlock_t;
+
+void my_rwlock_init(my_rwlock_t* lock, int priority_mode);
+void my_rwlock_destroy(my_rwlock_t* lock);
+void my_rwlock_rdlock(my_rwlock_t* lock);
+void my_rwlock_wrlock(my_rwlock_t* lock);
+void my_rwlock_unlock(my_rwlock_t* lock);
+#ifdef INSTRUMENT
+void my_rwlock_print_stats(const my_rwlock_t* lock, FILE* stream);
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+/* File:     node_pool.h
+ * Purpose:  Header file for node_pool.c, a per-thread pool allocator for
+ *           fixed-size nodes carved from large aligned arenas.
+ *
+ * Notes:
+ * 1.  np_alloc and np_free only touch the calling thread's state: a
+ *     free list of returned nodes and the unused tail of its current
+ *     arena.  Neither takes a lock or calls malloc in the common case.
+ * 2.  A node freed by another thread than the one that allocated it goes
+ *     to the freeing thread's list.  Memory is returned to the system
+ *     only by np_destroy, which releases all arenas at once.
+ * 3.  Threads are identified by rank, 0 ... thread_count-1, and each rank
+ *     must be used by one thread at a time.
+ */
+#ifndef _NODE_POOL_H_
+#define _NODE_POOL_H_
+
+#include <stddef.h>
+
+#define NP_CACHE_LINE 64
+#define NP_ARENA_BYTES (1 << 20)
+
+typedef struct np_free {
+  struct np_free* next;
+} np_free_t;
+
+typedef struct {
+  np_free_t* free_list; /* Nodes returned by this thread */
+  char* bump;           /* Next unused byte of the current arena */
+  char* bump_end;
+  void** arenas; /* Every arena this thread allocated */
+  size_t arena_count;
+  size_t arena_capacity;
+} __attribute__((aligned(NP_CACHE_LINE))) np_local_t;
+
+typedef struct {
+  size_t node_size; /* Rounded up to a multiple of the alignment */
+  int thread_count;
+  np_local_t* locals; /* One per rank */
+} node_pool_t;
+
+int np_init(node_pool_t* pool, size_t node_size, int thread_count);
+void np_destroy(node_pool_t* pool);
+void* np_alloc(node_pool_t* pool, long rank);
+void np_free(node_pool_t* pool, long rank, void* node);
+
+#endif
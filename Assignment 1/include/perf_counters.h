@@ -0,0 +1,43 @@
+/* File:     perf_counters.h
+ * Purpose:  Header file for perf_counters.c, which reads hardware event
+ *           counters of the calling process through perf_event_open.
+ *
+ * Notes:
+ * 1.  The counters are opened with inherit set, so they also count every
+ *     thread created after pc_open; open them before starting the threads.
+ * 2.  Only user-space events are counted, which perf_event_paranoid <= 2
+ *     allows.  An event that cannot be opened (no PMU in a VM, paranoid
+ *     setting, unknown raw event) is reported as n/a.
+ * 3.  When there are more events than hardware counters, the kernel
+ *     multiplexes them and each one only counts part of the time.  Such
+ *     counts are scaled up to the whole run and printed as multiplexed,
+ *     with the fraction of the run that was actually counted.
+ */
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include <stdio.h>
+
+typedef enum {
+  PC_CYCLES,       /* CPU cycles */
+  PC_INSTRUCTIONS, /* Instructions retired */
+  PC_CACHE_MISSES, /* Last-level cache misses */
+  PC_L1D_MISSES,   /* L1 data cache read misses */
+  PC_HITM,         /* Loads that hit a modified line in another core */
+  PC_EVENT_COUNT
+} pc_event_t;
+
+typedef struct {
+  int fd[PC_EVENT_COUNT];                   /* -1 if not available */
+  unsigned long long value[PC_EVENT_COUNT]; /* Counts after pc_stop, scaled */
+  unsigned long long enabled[PC_EVENT_COUNT]; /* ns the event was enabled */
+  unsigned long long running[PC_EVENT_COUNT]; /* ns it was really counted */
+} perf_counters_t;
+
+void pc_open(perf_counters_t* pc);
+void pc_start(perf_counters_t* pc);
+void pc_stop(perf_counters_t* pc);
+void pc_close(perf_counters_t* pc);
+void pc_print(const perf_counters_t* pc, unsigned long long ops, FILE* out);
+
+#endif
@@ -0,0 +1,30 @@
+/* File:     philox.h
+ * Purpose:  Header file for philox.c, which implements the Philox4x32-10
+ *           counter-based pseudo-random number generator.
+ *
+ * Notes:
+ * 1.  The generator has no state besides the seed: word p of the stream
+ *     with a given seed is a pure function of (seed, p).  Any thread can
+ *     therefore produce any slice of the stream without coordination,
+ *     and a parallel run that splits [0, n) into slices sees exactly the
+ *     numbers a serial run would.
+ * 2.  Words are generated PHILOX_BATCH counters at a time in
+ *     structure-of-arrays form, so the rounds vectorize (AVX2/AVX-512)
+ *     when compiled with optimization.
+ */
+#ifndef _PHILOX_H_
+#define _PHILOX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Counters processed per vectorized batch; each counter gives 4 words */
+#define PHILOX_BATCH 64
+#define PHILOX_BATCH_WORDS (4 * PHILOX_BATCH)
+
+void philox4x32(const uint32_t ctr[4], uint64_t seed, uint32_t out[4]);
+void philox_fill_u32(uint64_t seed, uint64_t first, uint32_t* buf, size_t n);
+void philox_fill_float(uint64_t seed, uint64_t first, float* buf, size_t n);
+void philox_fill_double(uint64_t seed, uint64_t first, double* buf, size_t n);
+
+#endif
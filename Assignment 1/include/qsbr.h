@@ -0,0 +1,43 @@
+/* File:     qsbr.h
+ * Purpose:  Header file for qsbr.c, quiescent-state-based reclamation for
+ *           structures whose readers take no lock (RCU).
+ *
+ * Notes:
+ * 1.  Unlike epoch.h there is nothing to call when an operation starts.
+ *     A thread calls qsbr_quiescent whenever it holds no pointer into the
+ *     structure, e.g. after each operation.  Memory unlinked by a writer
+ *     goes to qsbr_retire and is freed once every thread has passed a
+ *     quiescent state after the unlink (a grace period).
+ * 2.  Threads are identified by rank, 0 ... thread_count-1, and each rank
+ *     must be used by one thread at a time.
+ */
+#ifndef _QSBR_H_
+#define _QSBR_H_
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define QSBR_CACHE_LINE 64
+
+typedef struct {
+  _Atomic unsigned long seen; /* Counter read at the last quiescent state */
+  void** items;               /* Retired by this thread, oldest first */
+  unsigned long* tags;        /* Counter value each one must be seen at */
+  size_t count;
+  size_t capacity;
+  int retired_since_reclaim;
+} __attribute__((aligned(QSBR_CACHE_LINE))) qsbr_slot_t;
+
+typedef struct {
+  _Atomic unsigned long counter __attribute__((aligned(QSBR_CACHE_LINE)));
+  int thread_count;
+  void (*free_fn)(void*);
+  qsbr_slot_t* slots;
+} qsbr_t;
+
+int qsbr_init(qsbr_t* qsbr, int thread_count, void (*free_fn)(void*));
+void qsbr_destroy(qsbr_t* qsbr);
+void qsbr_quiescent(qsbr_t* qsbr, long rank);
+void qsbr_retire(qsbr_t* qsbr, long rank, void* item);
+
+#endif
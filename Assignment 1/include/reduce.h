@@ -0,0 +1,63 @@
+/* File:     reduce.h
+ * Purpose:  Header file for reduce.c, a reduction library for doubles:
+ *           vectorized reduction of an array within a thread, and
+ *           combining of per-thread results across a team of threads.
+ *
+ * Notes:
+ * 1.  An operator is an associative function with its identity.
+ *     REDUCE_SUM, REDUCE_MIN and REDUCE_MAX have vectorized loops; any
+ *     other operator is applied through its function pointer.
+ * 2.  A reducer_t combines one value per thread of a team in
+ *     log2(thread_count) barrier-separated levels.  In NUMA-aware mode the
+ *     threads are ordered by NUMA node before the tree is built, so the
+ *     lower levels combine within a node and only the top levels cross
+ *     nodes.
+ */
+#ifndef _REDUCE_H_
+#define _REDUCE_H_
+
+#include <pthread.h>
+#include <stddef.h>
+
+#define REDUCE_CACHE_LINE 64
+
+typedef double (*reduce_fn_t)(double a, double b);
+
+typedef struct {
+  reduce_fn_t combine; /* Associative: combine(combine(a, b), c) ==
+                          combine(a, combine(b, c)) */
+  double identity;     /* combine(identity, a) == a */
+} reduce_op_t;
+
+extern const reduce_op_t REDUCE_SUM;
+extern const reduce_op_t REDUCE_MIN;
+extern const reduce_op_t REDUCE_MAX;
+
+/* One thread's value, alone on its cache line */
+typedef struct {
+  double value;
+  int node; /* NUMA node the thread ran on when it arrived */
+} __attribute__((aligned(REDUCE_CACHE_LINE))) reduce_slot_t;
+
+typedef struct {
+  int thread_count;
+  int numa_aware;
+  const reduce_op_t* op;
+  reduce_slot_t* slots; /* One per rank */
+  int* order;           /* Ranks in tree order */
+  int* position;        /* Inverse of order */
+  double result;        /* Result of the last reducer_combine */
+  pthread_barrier_t barrier;
+} reducer_t;
+
+double reduce_local(const double* a, size_t n, const reduce_op_t* op);
+
+int reducer_init(reducer_t* reducer, int thread_count, const reduce_op_t* op,
+                 int numa_aware);
+double reducer_combine(reducer_t* reducer, long rank, double value);
+void reducer_destroy(reducer_t* reducer);
+
+double reduce_parallel(const double* a, size_t n, int thread_count,
+                       const reduce_op_t* op, int numa_aware);
+
+#endif
@@ -0,0 +1,52 @@
+/* File:     set_backend.h
+ * Purpose:  Interface of the concurrent sets of ints that rw_lock.c can
+ *           benchmark, and the list of available implementations.
+ *
+ * Notes:
+ * 1.  insert, member and delete have the semantics of Insert, Member and
+ *     Delete in rw_lock.c (return 1 if the set changed / the key is
+ *     present, 0 otherwise) and are safe to call from any number of
+ *     threads at once.
+ * 2.  rank identifies the calling thread, 0 ... thread_count-1, for
+ *     backends with per-thread state.  main may use rank 0 while no other
+ *     thread runs.
+ * 3.  batch is optional (NULL if the backend has none).  It applies count
+ *     ops at once and atomically with respect to the other operations,
+ *     sorting ops by key in place; ops with the same key keep the order
+ *     they were submitted in.  Each op gets the result its single call
+ *     would have returned, and batch returns how many results are 1.
+ * 4.  scan is optional too.  It returns how many keys are in [low, high),
+ *     as the set was at a single instant during the call.
+ */
+#ifndef _SET_BACKEND_H_
+#define _SET_BACKEND_H_
+
+#include "workload.h"
+
+/* One operation of a batch */
+typedef struct {
+  int key;
+  wl_op_t op;
+  int result; /* Set by batch */
+  int index;  /* Set by batch: position in the batch as submitted */
+} set_op_t;
+
+typedef struct {
+  const char* name; /* Name on the command line (-m) */
+  void* (*create)(int thread_count);
+  int (*insert)(void* set, int value, long rank);
+  int (*member)(void* set, int value, long rank);
+  int (*delete)(void* set, int value, long rank);
+  void (*destroy)(void* set);
+  int (*batch)(void* set, set_op_t* ops, int count, long rank);
+  int (*scan)(void* set, int low, int high, long rank);
+} set_backend_t;
+
+extern const set_backend_t skiplist_backend; /* skiplist.c */
+extern const set_backend_t hoh_backend;      /* hoh_list.c */
+extern const set_backend_t harris_backend;   /* harris_list.c */
+extern const set_backend_t rcu_backend;      /* rcu_list.c */
+extern const set_backend_t hash_backend;     /* hash_set.c */
+extern const set_backend_t mvcc_backend;     /* mvcc_list.c */
+
+#endif
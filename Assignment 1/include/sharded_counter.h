@@ -0,0 +1,43 @@
+/* File:     sharded_counter.h
+ * Purpose:  Header file for sharded_counter.c, a counter split into
+ *           cache-line padded slots so that concurrent updates do not
+ *           share a cache line.
+ *
+ * Notes:
+ * 1.  Thread t adds to slot t % slot_count.  With one slot per thread
+ *     every slot has a single writer and its line stays in that core's
+ *     cache.
+ * 2.  sc_add is wait-free, sc_read is a fast approximate read and sc_sum
+ *     an exact snapshot; see sharded_counter.c.
+ */
+#ifndef _SHARDED_COUNTER_H_
+#define _SHARDED_COUNTER_H_
+
+#include <stdatomic.h>
+
+/* Two lines, so the adjacent-line prefetcher does not couple neighbours */
+#define SC_SLOT_SIZE 128
+
+typedef struct {
+  _Atomic unsigned long long value;
+} __attribute__((aligned(SC_SLOT_SIZE))) sc_slot_t;
+
+typedef struct {
+  int slot_count;
+  sc_slot_t* slots;
+} sharded_counter_t;
+
+int sc_init(sharded_counter_t* counter, int slot_count);
+void sc_destroy(sharded_counter_t* counter);
+unsigned long long sc_read(sharded_counter_t* counter);
+unsigned long long sc_sum(sharded_counter_t* counter);
+
+/* Adds n to the slot of thread rank; an uncontended atomic add on a line
+ * the thread usually owns already */
+static inline void sc_add(sharded_counter_t* counter, long rank,
+                          unsigned long long n) {
+  atomic_fetch_add_explicit(&counter->slots[rank % counter->slot_count].value,
+                            n, memory_order_relaxed);
+}
+
+#endif
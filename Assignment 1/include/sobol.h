@@ -0,0 +1,32 @@
+/* File:     sobol.h
+ * Purpose:  Header file for sobol.c, which generates the Sobol
+ *           low-discrepancy sequence in up to SOBOL_MAX_DIM dimensions.
+ *
+ * Notes:
+ * 1.  Points are produced in Gray-code order, so consecutive points
+ *     differ by one direction number per coordinate.
+ * 2.  sobol_init can start at any index in O(SOBOL_BITS * dim) steps, so
+ *     each thread can take a contiguous range of the sequence and start
+ *     generating right away.
+ */
+#ifndef _SOBOL_H_
+#define _SOBOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SOBOL_MAX_DIM 10
+#define SOBOL_BITS 32
+
+typedef struct {
+  int dim;                               /* Dimensions in use */
+  unsigned long long index;              /* Index of the next point */
+  uint32_t x[SOBOL_MAX_DIM];             /* Coordinates of the next point */
+  uint32_t v[SOBOL_MAX_DIM][SOBOL_BITS]; /* Direction numbers */
+} sobol_t;
+
+int sobol_init(sobol_t* sobol, int dim, unsigned long long start);
+void sobol_next(sobol_t* sobol, double* point);
+void sobol_fill(sobol_t* sobol, double* points, size_t n);
+
+#endif
@@ -0,0 +1,45 @@
+/* File:     unrolled_list.h
+ * Purpose:  Header file for unrolled_list.c, a sorted set of ints kept in
+ *           a linked list of cache-line aligned blocks of sorted keys.
+ *
+ * Notes:
+ * 1.  A block holds up to UL_BLOCK_KEYS keys in UL_BLOCK_BYTES bytes.  A
+ *     full block is split in two; a block left with fewer than
+ *     UL_MIN_KEYS keys takes keys from the next one, or absorbs it.  Only
+ *     the last block may be shorter, and the first is never freed.
+ * 2.  Key slots past count hold INT_MAX, so a block is searched with
+ *     whole vectors whatever its count.
+ * 3.  Nothing here is thread-safe: rw_lock.c calls it under its lock,
+ *     like the functions on its list of list_node_s.
+ */
+#ifndef _UNROLLED_LIST_H_
+#define _UNROLLED_LIST_H_
+
+#include <stdio.h>
+
+#include "set_backend.h"
+
+#define UL_BLOCK_BYTES 256
+#define UL_BLOCK_KEYS 56 /* A multiple of the widest vector, 8 ints */
+#define UL_MIN_KEYS (UL_BLOCK_KEYS / 4)
+
+typedef struct ul_block {
+  int keys[UL_BLOCK_KEYS]; /* Sorted, then INT_MAX */
+  int count;
+  struct ul_block* next;
+} __attribute__((aligned(64))) ul_block_t;
+
+typedef struct {
+  ul_block_t* head; /* Never NULL */
+} unrolled_list_t;
+
+int ul_init(unrolled_list_t* list);
+void ul_destroy(unrolled_list_t* list);
+int ul_insert(unrolled_list_t* list, int value);
+int ul_member(const unrolled_list_t* list, int value);
+int ul_delete(unrolled_list_t* list, int value);
+int ul_apply_batch(unrolled_list_t* list, set_op_t* ops, int count);
+int ul_scan(const unrolled_list_t* list, int low, int high);
+void ul_print(const unrolled_list_t* list, FILE* stream);
+
+#endif
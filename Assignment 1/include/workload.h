@@ -0,0 +1,73 @@
+/* File:     workload.h
+ * Purpose:  Header file for workload.c, which parses workload specs for
+ *           the list benchmarks and generates their operations.
+ *
+ * Notes:
+ * 1.  A spec is a sequence of phases separated by ';' or newlines.  Each
+ *     phase is a list of name=value settings separated by spaces or
+ *     commas; '#' starts a comment that runs to the end of the line:
+ *
+ *       init=1000 keys=100000
+ *       member=0.9 insert=0.05 dist=zipf:0.99 time=2
+ *       member=0.5 insert=0.4 dist=hotspot:0.01:0.9 ops=200000
+ *
+ *     init (keys inserted before the first phase) and keys (keys are
+ *     drawn from 0 ... keys-1, keys <= INT_MAX) apply to the whole run.
+ *     Every phase needs ops= (operations in total) or time= (seconds), and
+ *     takes the op mix and dist it does not set from the phase before.
+ *     delete= defaults to what member=, insert= and scan= leave.
+ * 2.  scan= is the fraction of range scans, which count the keys present
+ *     in [key, key + range) for a drawn key; range= defaults to 100.
+ * 3.  dist is uniform, zipf[:theta] (0 < theta < 1, default 0.99),
+ *     hotspot[:keys_fraction[:ops_fraction]] (default 0.2:0.8) or
+ *     sequential.  Zipf and hotspot ranks are scattered over the key
+ *     range, so the hot keys are not just the head of a sorted list.
+ */
+#ifndef _WORKLOAD_H_
+#define _WORKLOAD_H_
+
+typedef enum { WL_MEMBER, WL_INSERT, WL_DELETE, WL_SCAN, WL_OP_COUNT } wl_op_t;
+
+typedef enum {
+  WL_UNIFORM,
+  WL_ZIPF,
+  WL_HOTSPOT,
+  WL_SEQUENTIAL
+} wl_dist_kind_t;
+
+typedef struct {
+  double member; /* Fraction of Member ops */
+  double insert; /* Fraction of Insert ops */
+  double scan;   /* Fraction of range scans, the rest are Delete */
+  long long range; /* Keys a scan covers, from the key drawn on */
+  long long ops; /* Operations in the phase, or 0 */
+  double seconds; /* Duration of the phase if ops is 0 */
+  wl_dist_kind_t dist;
+  double theta;          /* zipf */
+  double hot_keys;       /* hotspot: fraction of the keys that are hot */
+  double hot_ops;        /* hotspot: fraction of the ops on them */
+  double zeta_n, alpha, eta; /* zipf constants for this key range */
+} wl_phase_t;
+
+typedef struct {
+  long long init; /* Keys inserted before the first phase */
+  long long keys; /* Keys are 0 ... keys-1 */
+  int phase_count;
+  wl_phase_t* phases;
+} workload_t;
+
+/* Per-thread generator state */
+typedef struct {
+  unsigned seed;           /* my_rand state */
+  unsigned long long next; /* Next rank of the sequential distribution */
+  int stride;
+} wl_gen_t;
+
+int wl_load(workload_t* wl, const char* spec, long long default_keys);
+void wl_free(workload_t* wl);
+void wl_print(const workload_t* wl);
+void wl_gen_init(wl_gen_t* gen, unsigned seed, long rank, int thread_count);
+wl_op_t wl_next(const workload_t* wl, int phase, wl_gen_t* gen, int* key);
+const char* wl_op_name(wl_op_t op);
+
+#endif
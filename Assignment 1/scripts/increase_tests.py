@@ -12,12 +12,23 @@ IMPLEMENTATIONS = {
     "increase": "../build/increase",
     "increase_atomic": "../build/increase_atomic"
 }
+# Implementations that update the shared counter on every iteration, as
+# executable plus extra arguments; far slower per iteration, so they run
+# with their own iteration counts
+CONTENDED_IMPLEMENTATIONS = {
+    "increase_mutex_contended": ["../build/increase", "mutex", "contended"],
+    "increase_ttas_contended": ["../build/increase", "ttas", "contended"],
+    "increase_mcs_contended": ["../build/increase", "mcs", "contended"],
+    "increase_atomic_contended": ["../build/increase_atomic", "contended"],
+    "increase_sharded": ["../build/increase_sharded"]
+}
 OUTPUT_CSV = "increase_results.csv"
 THREAD_COUNTS = [2, 4, 8, 16]
 ITERATIONS_VALUES = [34100654080, 45230187465, 98310427653]
+CONTENDED_ITERATIONS_VALUES = [100000000, 400000000]
 RUNS_PER_TEST = 5
 
-def run_test(exec_path: Path, implementation_name: str, iterations: int, csv_writer: csv.writer):
+def run_test(exec_path: Path, implementation_name: str, iterations: int, csv_writer: csv.writer, extra_args=()):
     """
     Runs the specified implementation executable with different thread counts
     and iterations, measures execution times, and records the results to the CSV file.
@@ -27,6 +38,7 @@ def run_test(exec_path: Path, implementation_name: str, iterations: int, csv_wri
         implementation_name (str): Name of the implementation (for display and CSV).
         iterations (int): Number of iterations to test.
         csv_writer (csv.writer): CSV writer object to record the results.
+        extra_args: Arguments passed after the iterations.
     """
     for threads in THREAD_COUNTS:
         print(f"\nTesting {implementation_name} with {threads} threads and {iterations} iterations")
@@ -42,7 +54,7 @@ def run_test(exec_path: Path, implementation_name: str, iterations: int, csv_wri
             try:
                 # Run the executable with the specified number of threads and iterations
                 subprocess.run(
-                    [str(exec_path), str(threads), str(iterations)],
+                    [str(exec_path), str(threads), str(iterations), *extra_args],
                     stdout=subprocess.DEVNULL,
                     stderr=subprocess.DEVNULL,
                     check=True
@@ -81,7 +93,15 @@ def main():
         else:
             print(f"Warning: Executable '{exec_path}' not found or not executable. Skipping '{name}'.")
 
-    if not valid_implementations:
+    valid_contended = {}
+    for name, command in CONTENDED_IMPLEMENTATIONS.items():
+        exec_path = Path(command[0])
+        if exec_path.is_file() and os.access(exec_path, os.X_OK):
+            valid_contended[name] = (exec_path, command[1:])
+        else:
+            print(f"Warning: Executable '{exec_path}' not found or not executable. Skipping '{name}'.")
+
+    if not valid_implementations and not valid_contended:
         print("Error: No valid implementation executables found. Exiting.")
         sys.exit(1)
 
@@ -97,6 +117,10 @@ def main():
                 for iterations in ITERATIONS_VALUES:
                     run_test(exec_path, implementation_name, iterations, csv_writer)
 
+            for implementation_name, (exec_path, extra_args) in valid_contended.items():
+                for iterations in CONTENDED_ITERATIONS_VALUES:
+                    run_test(exec_path, implementation_name, iterations, csv_writer, extra_args)
+
         # Notify completion
         print(f"\nAll tests completed. Results saved to {OUTPUT_CSV}.")
 
@@ -24,21 +24,24 @@ def plot_results(csv_file):
     # Set the style of the plots
     plt.style.use('ggplot')
     
-    # List of unique priority_modes and member_percents
-    priority_modes_unique = df['priority_mode'].unique()
+    # Older result files have no mode column: they only hold the global rwlock
+    if 'mode' not in df.columns:
+        df['mode'] = 'rwlock'
+    
+    # List of unique (mode, priority_mode) series and member_percents
+    series_unique = df[['mode', 'priority_mode']].drop_duplicates().itertuples(index=False)
+    series_unique = [tuple(series) for series in series_unique]
     member_percents_unique = sorted(df['member_percent'].unique(), reverse=True)
     thread_counts_unique = sorted(df['num_threads'].unique())
     
     # Create a combined plot
     plt.figure(figsize=(12, 8))
     
-    line_styles = {
-        priority_modes_unique[0]: '-',
-        priority_modes_unique[1]: '--'
-    }
+    styles = ['-', '--', ':', '-.']
+    line_styles = {series: styles[i % len(styles)] for i, series in enumerate(series_unique)}
     
-    for priority in priority_modes_unique:
-        subset = df[df['priority_mode'] == priority]
+    for mode, priority in series_unique:
+        subset = df[(df['mode'] == mode) & (df['priority_mode'] == priority)]
         
         for member_percent in member_percents_unique:
             data = subset[subset['member_percent'] == member_percent]
@@ -46,8 +49,8 @@ def plot_results(csv_file):
                 data['num_threads'],
                 data['average_elapsed_time'],
                 marker='o',
-                linestyle=line_styles[priority],
-                label=f'{priority.capitalize()} - Member: {member_percent*100:.1f}%'
+                linestyle=line_styles[(mode, priority)],
+                label=f'{mode} {priority.capitalize()} - Member: {member_percent*100:.1f}%'
             )
     
     # Add title and labels
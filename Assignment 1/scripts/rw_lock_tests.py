@@ -6,9 +6,10 @@ import sys
 import os
 from statistics import mean
 
-def run_rw_lock(num_threads, priority_mode, member_percent, insert_percent):
+def run_rw_lock(num_threads, priority_mode, member_percent, insert_percent, mode="rwlock"):
     """
     Executes the rw_lock program with the given parameters and returns the execution time.
+    mode selects the set implementation (-m); priority_mode only matters for rwlock.
     """
     # Path to the rw_lock program
     rw_lock_path = "../build/rw_lock"
@@ -27,7 +28,7 @@ def run_rw_lock(num_threads, priority_mode, member_percent, insert_percent):
     try:
         # Execute the program with subprocess
         result = subprocess.run(
-            [rw_lock_path, str(num_threads), priority_mode],
+            [rw_lock_path, str(num_threads), priority_mode, "-m", mode],
             input=inputs,
             text=True,
             capture_output=True,
@@ -65,20 +66,21 @@ def main():
     # Define the CSV file for saving the results
     output_file = "rw_lock_results.csv"
     
-    # Define the test parameters
-    priority_modes = ["read", "write"]
+    # Define the test parameters: (mode, priority_mode) pairs, the global
+    # lock with both priorities next to hand-over-hand locking
+    configurations = [("rwlock", "read"), ("rwlock", "write"), ("hoh", "read")]
     thread_counts = [2, 4, 8, 16]
-    member_percents = [0.999, 0.95, 0.90]
+    member_percents = [0.999, 0.95, 0.90, 0.80, 0.50]  # Last two insert-heavy
     num_runs = 5  # Number of repetitions per test
     
     # Create and write the header in the CSV file
     with open(output_file, mode='w', newline='') as csvfile:
         csv_writer = csv.writer(csvfile)
-        csv_writer.writerow(["priority_mode", "num_threads", "member_percent", "average_elapsed_time"])
+        csv_writer.writerow(["mode", "priority_mode", "num_threads", "member_percent", "average_elapsed_time"])
         
-        # Loop for each priority mode
-        for priority_mode in priority_modes:
-            print(f"Running tests with priority_mode: {priority_mode}")
+        # Loop for each configuration
+        for mode, priority_mode in configurations:
+            print(f"Running tests with mode: {mode}, priority_mode: {priority_mode}")
             
             # Loop for each thread count
             for num_threads in thread_counts:
@@ -94,7 +96,7 @@ def main():
                     # Execute the tests
                     for run in range(1, num_runs + 1):
                         print(f"      Run {run}...")
-                        elapsed = run_rw_lock(num_threads, priority_mode, member_percent, insert_percent)
+                        elapsed = run_rw_lock(num_threads, priority_mode, member_percent, insert_percent, mode)
                         if elapsed is not None:
                             elapsed_times.append(elapsed)
                             print(f"        Elapsed time: {elapsed} seconds")
@@ -109,7 +111,7 @@ def main():
                         average_str = "N/A"
                     
                     # Write the results to the CSV
-                    csv_writer.writerow([priority_mode, num_threads, member_percent, average_str])
+                    csv_writer.writerow([mode, priority_mode, num_threads, member_percent, average_str])
                     
                     print(f"      Average elapsed time: {average_str} seconds\n")
     
@@ -0,0 +1,176 @@
+#include <math.h>
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "philox.h"
+
+#define MC_SEED 20241117ULL  // Same Philox key as monte_carlo_pi.c
+#define MC_CHUNK 4096        // Points generated per Philox fill
+#define MC_ROUNDS 10         // Default number of progress reports
+
+// Hybrid MPI + OpenMP version of the 'philox' mode of monte_carlo_pi.c.
+//
+// The points [0, total_points) are split into one contiguous block per
+// rank, and each rank's block into one per OpenMP thread.  Point i always
+// uses words 2i and 2i+1 of the Philox stream with key MC_SEED, so every
+// rank and thread draws from its own disjoint slice of the stream and the
+// estimate is the same for any number of ranks and threads, including a
+// single process (and the same as './monte_carlo <threads> <points>
+// philox').
+//
+// Each rank works through its block in rounds.  After a round its running
+// totals go into a non-blocking MPI_Iallreduce, which completes while the
+// next round is computed; rank 0 prints the global estimate so far when it
+// does.  The reduction of the last round gives the final counts.
+
+long long total_points;  // Total number of points to be thrown
+
+void GetRange(long long n, long long parts, long long part,
+              long long* first_p, long long* count_p);
+long long CountPoints(long long first, long long count);
+void PrintRound(int round, const long long totals[2]);
+
+int main(int argc, char* argv[]) {
+  int provided, rank, size;
+
+  // Only the master thread of each rank calls MPI
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  if (provided < MPI_THREAD_FUNNELED) {
+    if (rank == 0) {
+      fprintf(stderr,
+              "Error: The MPI library does not support MPI_THREAD_FUNNELED, "
+              "which the OpenMP regions need.\n");
+    }
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+
+  if (argc < 3 || argc > 4) {
+    if (rank == 0) {
+      fprintf(stderr,
+              "Usage: mpirun -np <ranks> %s <threads per rank> <number of "
+              "points> [rounds]\n",
+              argv[0]);
+    }
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+
+  int thread_count = strtol(argv[1], NULL, 10);
+  total_points = strtoll(argv[2], NULL, 10);
+  int rounds = argc == 4 ? strtol(argv[3], NULL, 10) : MC_ROUNDS;
+
+  if (thread_count <= 0 || total_points <= 0 || rounds <= 0) {
+    if (rank == 0) {
+      fprintf(stderr,
+              "Error: Number of threads, points and rounds must be positive "
+              "integers.\n");
+    }
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+  omp_set_num_threads(thread_count);
+
+  long long first, count;
+  GetRange(total_points, size, rank, &first, &count);
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  double start = MPI_Wtime();
+
+  // totals[0] is the number of hits and totals[1] the number of points;
+  // two buffers so a reduction can be in flight while the next round runs
+  long long local[2] = {0, 0};
+  long long sent[2][2], global[2][2];
+  MPI_Request request = MPI_REQUEST_NULL;
+  int pending = -1;  // Round whose reduction is in flight
+
+  for (int round = 0; round < rounds; round++) {
+    long long round_first, round_count;
+    GetRange(count, rounds, round, &round_first, &round_count);
+    local[0] += CountPoints(first + round_first, round_count);
+    local[1] += round_count;
+
+    // The previous reduction had this whole round to make progress
+    if (pending >= 0) {
+      MPI_Wait(&request, MPI_STATUS_IGNORE);
+      if (rank == 0) PrintRound(pending, global[pending % 2]);
+    }
+    sent[round % 2][0] = local[0];
+    sent[round % 2][1] = local[1];
+    MPI_Iallreduce(sent[round % 2], global[round % 2], 2, MPI_LONG_LONG,
+                   MPI_SUM, MPI_COMM_WORLD, &request);
+    pending = round;
+  }
+  MPI_Wait(&request, MPI_STATUS_IGNORE);
+  if (rank == 0) PrintRound(pending, global[pending % 2]);
+
+  long long points_in_circle = global[(rounds - 1) % 2][0];
+  double finish = MPI_Wtime();
+
+  if (rank == 0) {
+    double pi_estimate = 4.0 * points_in_circle / total_points;
+    printf("Ranks: %d, threads per rank: %d\n", size, thread_count);
+    printf("Parallel π estimate: %f\n", pi_estimate);
+    printf("Absolute error: %e\n", fabs(pi_estimate - M_PI));
+    printf("Parallel time: %f seconds\n", finish - start);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+
+// Counts the points first ... first+count-1 that fall inside the unit
+// circle, splitting them among the OpenMP threads of the rank
+long long CountPoints(long long first, long long count) {
+  long long hits = 0;
+
+#pragma omp parallel reduction(+ : hits)
+  {
+    float xy[2 * MC_CHUNK];
+    long long my_first, my_count;
+    GetRange(count, omp_get_num_threads(), omp_get_thread_num(), &my_first,
+             &my_count);
+    my_first += first;
+
+    while (my_count > 0) {
+      int n = my_count < MC_CHUNK ? (int)my_count : MC_CHUNK;
+      philox_fill_float(MC_SEED, 2 * my_first, xy, 2 * n);
+      for (int i = 0; i < n; i++) {
+        float x = xy[2 * i] * 2.0f - 1.0f;
+        float y = xy[2 * i + 1] * 2.0f - 1.0f;
+        hits += (x * x + y * y) <= 1.0f;
+      }
+      my_first += n;
+      my_count -= n;
+    }
+  }
+  return hits;
+}
+
+// Block part of n items split into parts blocks, the remainder going to
+// the first blocks
+void GetRange(long long n, long long parts, long long part,
+              long long* first_p, long long* count_p) {
+  long long quotient = n / parts;
+  long long remainder = n % parts;
+
+  if (part < remainder) {
+    *count_p = quotient + 1;
+    *first_p = part * *count_p;
+  } else {
+    *count_p = quotient;
+    *first_p = part * quotient + remainder;
+  }
+}
+
+// Prints the global estimate after round (counted from 0), given the
+// reduced totals of hits and points
+void PrintRound(int round, const long long totals[2]) {
+  printf("Round %d: π ≈ %f from %lld points\n", round + 1,
+         4.0 * totals[0] / totals[1], totals[1]);
+}
@@ -1,21 +1,77 @@
 #include <bits/time.h>
+#include <math.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "mc_integrate.h"
+#include "my_rand.h"
+#include "philox.h"
+#include "reduce.h"
+#include "sobol.h"
+
+#define MC_SEED 20241117ULL  // Philox key, fixed so runs are reproducible
+#define MC_LCG_SEED 1U       // my_rand seed of the 'lcg' mode
+#define MC_CHUNK 4096        // Points generated per Philox fill
+#define MC_BATCH 65536       // Points per published batch in 'adaptive' mode
+#define MC_MIN_BATCHES 16    // Batches folded in before testing for a stop
+#define MC_STRATUM_POINTS 16  // Target points per stratum in 'stratified'
+
 long long total_points;          // Total number of points to be thrown
 long long points_in_circle = 0;  // Total points inside the circle
 int thread_count;                // Number of threads
-pthread_mutex_t mutex;           // Mutex for synchronization
+#ifdef BASELINE_COMBINE
+pthread_mutex_t mutex;           // Guards the totals of the threads
+#else
+reducer_t reducer;               // Combines the totals of the threads
+#endif
+
+// Results of the variance-reduction modes: each thread adds its share of
+// the estimate and of the variance of the estimate
+double pi_sum = 0.0;              // Estimate of π
+double pi_variance = 0.0;         // Variance of the estimate
+long long points_evaluated = 0;   // Points the estimate is built from
+
+// State of the 'adaptive' mode
+double tolerance;                  // Target half-width of the interval
+double confidence;                 // Confidence level of the interval
+long long batch_count;             // Batches in the budget of total_points
+_Atomic long long next_batch = 0;  // Next batch to be claimed by a worker
+_Atomic int* batch_hits;           // Hits of each batch, -1 until published
+_Atomic int stop = 0;              // Raised once the tolerance is reached
 
 void* MonteCarloPiParallel(void* rank);
+void* MonteCarloPiPhilox(void* rank);
+void* MonteCarloPiLcg(void* rank);
+void* MonteCarloPiAdaptive(void* rank);
+void* MonteCarloPiSobol(void* rank);
+void* MonteCarloPiStratified(void* rank);
+void* MonteCarloPiAntithetic(void* rank);
+void* MonteCarloPiImportance(void* rank);
+double AdaptiveCoordinator(double* half_width_p, long long* points_used_p);
+double NormalQuantile(double confidence);
+int UnitBallVolume(int dim, mc_sampler_t sampler);
 double MonteCarloPiSequential(long long total_points);
+void GetThreadRange(long rank, long long* first_p, long long* count_p);
 double GetTime();
 
 int main(int argc, char* argv[]) {
-  if (argc != 3) {
-    fprintf(stderr, "Usage: %s <number of threads> <number of points>\n",
+  void* (*thread_work)(void*) = MonteCarloPiParallel;
+  int adaptive = 0, sobol = 0, variance_reduction = 0;
+
+  if (argc < 3 || argc > 6) {
+    fprintf(stderr,
+            "Usage: %s <number of threads> <number of points> [mode]\n"
+            "mode: 'rand_r' (default), 'philox', 'lcg', 'sobol',\n"
+            "      'stratified', 'antithetic', 'importance' or\n"
+            "      'adaptive <tolerance> <confidence>': stop as soon as the\n"
+            "      confidence interval is within the tolerance, using at\n"
+            "      most <number of points>\n"
+            "      'engine [dim [philox|sobol]]': volume of the unit ball in\n"
+            "      dim dimensions (default 2, i.e. π) with mc_integrate\n",
             argv[0]);
     exit(1);
   }
@@ -30,38 +86,159 @@ int main(int argc, char* argv[]) {
     exit(1);
   }
 
-  // Sequential Monte Carlo Simulation
-  double start = GetTime();
-  double pi_sequential = MonteCarloPiSequential(total_points);
-  double finish = GetTime();
-  printf("Sequential π estimate: %f\n", pi_sequential);
-  printf("Sequential time: %f seconds\n", finish - start);
+  if (argc >= 4) {
+    if (strcmp(argv[3], "adaptive") == 0 && argc == 6) {
+      thread_work = MonteCarloPiAdaptive;
+      adaptive = 1;
+      tolerance = strtod(argv[4], NULL);
+      confidence = strtod(argv[5], NULL);
+      if (tolerance <= 0 || confidence <= 0 || confidence >= 1) {
+        fprintf(stderr,
+                "Error: Tolerance must be positive and confidence in (0, "
+                "1).\n");
+        exit(1);
+      }
+    } else if (strcmp(argv[3], "engine") == 0 && argc <= 6) {
+      int dim = argc >= 5 ? strtol(argv[4], NULL, 10) : 2;
+      mc_sampler_t sampler = MC_PSEUDO;
+      if (argc == 6 && strcmp(argv[5], "sobol") == 0) {
+        sampler = MC_SOBOL;
+      } else if (argc == 6 && strcmp(argv[5], "philox") != 0) {
+        fprintf(stderr, "Error: Unknown sampler '%s'.\n", argv[5]);
+        exit(1);
+      }
+      return UnitBallVolume(dim, sampler);
+    } else if (argc != 4) {
+      fprintf(stderr, "Error: Unexpected arguments after '%s'.\n", argv[3]);
+      exit(1);
+    } else if (strcmp(argv[3], "philox") == 0) {
+      thread_work = MonteCarloPiPhilox;
+    } else if (strcmp(argv[3], "lcg") == 0) {
+      thread_work = MonteCarloPiLcg;
+    } else if (strcmp(argv[3], "sobol") == 0) {
+      thread_work = MonteCarloPiSobol;
+      sobol = 1;
+      if (total_points > (1LL << SOBOL_BITS)) {
+        fprintf(stderr, "Error: 'sobol' supports at most 2^%d points.\n",
+                SOBOL_BITS);
+        exit(1);
+      }
+    } else if (strcmp(argv[3], "stratified") == 0) {
+      thread_work = MonteCarloPiStratified;
+      variance_reduction = 1;
+    } else if (strcmp(argv[3], "antithetic") == 0) {
+      thread_work = MonteCarloPiAntithetic;
+      variance_reduction = 1;
+    } else if (strcmp(argv[3], "importance") == 0) {
+      thread_work = MonteCarloPiImportance;
+      variance_reduction = 1;
+    } else if (strcmp(argv[3], "rand_r") != 0) {
+      fprintf(stderr, "Error: Unknown mode '%s'.\n", argv[3]);
+      exit(1);
+    }
+  }
+
+  // Sequential Monte Carlo Simulation, skipped in 'adaptive' mode where
+  // the number of points is only an upper bound
+  double start, finish;
+  if (!adaptive) {
+    start = GetTime();
+    double pi_sequential = MonteCarloPiSequential(total_points);
+    finish = GetTime();
+    printf("Sequential π estimate: %f\n", pi_sequential);
+    printf("Sequential time: %f seconds\n", finish - start);
+  }
 
   // Parallel Monte Carlo Simulation
   pthread_t* thread_handles = malloc(thread_count * sizeof(pthread_t));
+#ifdef BASELINE_COMBINE
   pthread_mutex_init(&mutex, NULL);
+#else
+  if (reducer_init(&reducer, thread_count, &REDUCE_SUM, 0) != 0) {
+    fprintf(stderr, "Error: Could not allocate the reducer.\n");
+    exit(1);
+  }
+#endif
+
+  if (adaptive) {
+    batch_count = (total_points + MC_BATCH - 1) / MC_BATCH;
+    batch_hits = malloc(batch_count * sizeof(*batch_hits));
+    for (long long b = 0; b < batch_count; b++) {
+      atomic_init(&batch_hits[b], -1);
+    }
+  }
 
   start = GetTime();
   for (long thread = 0; thread < thread_count; thread++) {
-    pthread_create(&thread_handles[thread], NULL, MonteCarloPiParallel,
+    pthread_create(&thread_handles[thread], NULL, thread_work,
                    (void*)thread);
   }
 
+  double pi_parallel = 0.0, half_width = 0.0;
+  long long points_used = total_points;
+  if (adaptive) {
+    pi_parallel = AdaptiveCoordinator(&half_width, &points_used);
+  }
+
   for (long thread = 0; thread < thread_count; thread++) {
     pthread_join(thread_handles[thread], NULL);
   }
   finish = GetTime();
 
-  double pi_parallel = 4 * ((double)points_in_circle / (double)total_points);
+  if (variance_reduction) {
+    pi_parallel = pi_sum;
+  } else if (!adaptive) {
+    pi_parallel = 4 * ((double)points_in_circle / (double)total_points);
+  }
   printf("Parallel π estimate: %f\n", pi_parallel);
   printf("Parallel time: %f seconds\n", finish - start);
+  if (sobol) {
+    printf("Absolute error: %e\n", fabs(pi_parallel - M_PI));
+  }
+  if (variance_reduction) {
+    // Hit-or-miss scores 4 * [inside] with P(inside) = π / 4
+    double per_point = pi_variance * points_evaluated;
+    double hit_or_miss = M_PI * (4 - M_PI);
+    printf("Standard error: %e\n", sqrt(pi_variance));
+    printf("Variance per point: %f (hit-or-miss %f", per_point, hit_or_miss);
+    if (per_point > 0) {
+      printf(", %.1fx fewer points for the same error", hit_or_miss / per_point);
+    }
+    printf(")\n");
+  }
+  if (adaptive) {
+    printf("Confidence interval: %.8f +/- %.2e at %g%% confidence%s\n",
+           pi_parallel, half_width, 100 * confidence,
+           half_width <= tolerance ? "" : " (tolerance not reached)");
+    printf("Points used: %lld of %lld\n", points_used, total_points);
+    free(batch_hits);
+  }
 
+#ifdef BASELINE_COMBINE
   pthread_mutex_destroy(&mutex);
+#else
+  reducer_destroy(&reducer);
+#endif
   free(thread_handles);
 
   return 0;
 }
 
+// Adds a thread's hits to points_in_circle.  Every thread of the run must
+// call it: the counts are combined with a reducer_t tree (reduce.c), or
+// under the mutex when built with BASELINE_COMBINE
+static void AddHits(long rank, long long hits) {
+#ifdef BASELINE_COMBINE
+  pthread_mutex_lock(&mutex);
+  points_in_circle += hits;
+  pthread_mutex_unlock(&mutex);
+#else
+  // Counts below 2^53 are exact as doubles
+  double total = reducer_combine(&reducer, rank, (double)hits);
+  if (rank == 0) points_in_circle = (long long)total;
+#endif
+}
+
 void* MonteCarloPiParallel(void* rank) {
   unsigned seed =
       (unsigned)time(NULL) + (unsigned)(size_t)rank;  // Seed for random numbers
@@ -82,13 +259,378 @@ void* MonteCarloPiParallel(void* rank) {
     }
   }
 
+  AddHits((long)rank, local_points_in_circle);
+
+  return NULL;
+}
+
+// Counts the points of [-1, 1)^2 inside the unit circle; xy holds the
+// points as interleaved uniform [0, 1) coordinates
+static int CountInCircle(const float* xy, int n) {
+  int hits = 0;
+  for (int i = 0; i < n; i++) {
+    float x = xy[2 * i] * 2.0f - 1.0f;
+    float y = xy[2 * i + 1] * 2.0f - 1.0f;
+    hits += (x * x + y * y) <= 1.0f;
+  }
+  return hits;
+}
+
+// Point i of the run uses words 2i and 2i+1 of the Philox stream, so the
+// estimate does not depend on the number of threads
+void* MonteCarloPiPhilox(void* rank) {
+  float xy[2 * MC_CHUNK];
+  long long first, count;
+  long long local_points_in_circle = 0;
+
+  GetThreadRange((long)rank, &first, &count);
+
+  while (count > 0) {
+    int n = count < MC_CHUNK ? (int)count : MC_CHUNK;
+    philox_fill_float(MC_SEED, 2 * first, xy, 2 * n);
+    local_points_in_circle += CountInCircle(xy, n);
+    first += n;
+    count -= n;
+  }
+
+  AddHits((long)rank, local_points_in_circle);
+
+  return NULL;
+}
+
+// Same partitioning with the my_rand generator: point i uses numbers 2i
+// and 2i+1 after MC_LCG_SEED, and each thread jumps straight to its first
+// point, so the estimate matches a single-threaded run
+void* MonteCarloPiLcg(void* rank) {
+  double xy[2 * MC_CHUNK];
+  long long first, count;
+  long long local_points_in_circle = 0;
+
+  GetThreadRange((long)rank, &first, &count);
+  unsigned seed = my_rand_jump(MC_LCG_SEED, 2 * first);
+
+  while (count > 0) {
+    int n = count < MC_CHUNK ? (int)count : MC_CHUNK;
+    my_drand_fill(&seed, xy, 2 * n);
+    for (int i = 0; i < n; i++) {
+      double x = xy[2 * i] * 2.0 - 1.0;
+      double y = xy[2 * i + 1] * 2.0 - 1.0;
+      local_points_in_circle += (x * x + y * y) <= 1.0;
+    }
+    count -= n;
+  }
+
+  AddHits((long)rank, local_points_in_circle);
+
+  return NULL;
+}
+
+// Quasi-Monte Carlo: the points are the first total_points points of the
+// two-dimensional Sobol sequence in [0, 1)^2 and the estimate counts those
+// in the quarter circle.  Each thread fast-forwards to the start of its
+// contiguous range, so together they cover exactly the serial sequence.
+void* MonteCarloPiSobol(void* rank) {
+  double xy[2 * MC_CHUNK];
+  long long first, count;
+  long long local_points_in_circle = 0;
+  sobol_t sequence;
+
+  GetThreadRange((long)rank, &first, &count);
+  sobol_init(&sequence, 2, first);
+
+  while (count > 0) {
+    int n = count < MC_CHUNK ? (int)count : MC_CHUNK;
+    sobol_fill(&sequence, xy, n);
+    for (int i = 0; i < n; i++) {
+      local_points_in_circle +=
+          (xy[2 * i] * xy[2 * i] + xy[2 * i + 1] * xy[2 * i + 1]) <= 1.0;
+    }
+    count -= n;
+  }
+
+  AddHits((long)rank, local_points_in_circle);
+
+  return NULL;
+}
+
+// Adds a thread's result to the variance-reduction totals; estimate and
+// variance are those of the thread's own estimate of π from its count
+// points, of which evaluated were actually scored.  Like AddHits, every
+// thread must call it.
+static void AddEstimate(long rank, long long count, long long evaluated,
+                        double estimate, double variance) {
+  double weight = (double)count / total_points;
+
+#ifdef BASELINE_COMBINE
   pthread_mutex_lock(&mutex);
-  points_in_circle += local_points_in_circle;
+  pi_sum += weight * estimate;
+  pi_variance += weight * weight * variance;
+  points_evaluated += evaluated;
   pthread_mutex_unlock(&mutex);
+#else
+  double sum = reducer_combine(&reducer, rank, weight * estimate);
+  double var = reducer_combine(&reducer, rank, weight * weight * variance);
+  double points = reducer_combine(&reducer, rank, (double)evaluated);
+  if (rank == 0) {
+    pi_sum = sum;
+    pi_variance = var;
+    points_evaluated = (long long)points;
+  }
+#endif
+}
+
+// Stratified sampling: the thread splits [0, 1)^2 into a k x k grid with
+// about MC_STRATUM_POINTS points per stratum and estimates the quarter
+// circle stratum by stratum.  Only strata crossed by the circle have any
+// variance, so the variance falls with k.
+void* MonteCarloPiStratified(void* rank) {
+  float xy[2 * MC_CHUNK];
+  long long first, count;
+
+  GetThreadRange((long)rank, &first, &count);
+  if (count == 0) {  // Still takes part in combining the totals
+    AddEstimate((long)rank, 0, 0, 0.0, 0.0);
+    return NULL;
+  }
+
+  long long k = (long long)sqrt((double)count / MC_STRATUM_POINTS);
+  if (k < 1) k = 1;
+  long long strata = k * k;
+  long long base = count / strata, extra = count % strata;
+  long long next = first;  // Next point index of the Philox stream
+  int used = MC_CHUNK;     // Points of xy already consumed
+  double estimate = 0.0, variance = 0.0;
+
+  for (long long h = 0; h < strata; h++) {
+    long long n = base + (h < extra);
+    double x0 = (double)(h % k) / k, y0 = (double)(h / k) / k;
+    long long hits = 0;
+
+    for (long long i = 0; i < n; i++) {
+      if (used == MC_CHUNK) {
+        philox_fill_float(MC_SEED, 2 * next, xy, 2 * MC_CHUNK);
+        next += MC_CHUNK;
+        used = 0;
+      }
+      double x = x0 + xy[2 * used] / (double)k;
+      double y = y0 + xy[2 * used + 1] / (double)k;
+      hits += (x * x + y * y) <= 1.0;
+      used++;
+    }
+
+    // Each stratum has weight 1 / strata in the estimate
+    double p = (double)hits / n;
+    estimate += 4 * p / strata;
+    if (n > 1) {
+      variance += 16 * p * (1 - p) / (n - 1) / ((double)strata * strata);
+    }
+  }
+
+  AddEstimate((long)rank, count, count, estimate, variance);
+  return NULL;
+}
+
+// Antithetic pairs: every point u of [0, 1)^2 is paired with 1 - u.  A
+// point near the origin is inside the quarter circle and its partner near
+// (1, 1) is not, so the two scores are negatively correlated and their
+// average varies less than two independent points.  An odd count is
+// rounded up to whole pairs.
+void* MonteCarloPiAntithetic(void* rank) {
+  float xy[2 * MC_CHUNK];
+  long long first, count;
+  double sum = 0.0, sum_sq = 0.0;
+
+  GetThreadRange((long)rank, &first, &count);
+  if (count == 0) {  // Still takes part in combining the totals
+    AddEstimate((long)rank, 0, 0, 0.0, 0.0);
+    return NULL;
+  }
+  long long pairs = (count + 1) / 2;
+
+  for (long long done = 0; done < pairs;) {
+    int n = pairs - done < MC_CHUNK ? (int)(pairs - done) : MC_CHUNK;
+    philox_fill_float(MC_SEED, 2 * (first + done), xy, 2 * n);
+    for (int i = 0; i < n; i++) {
+      float x = xy[2 * i], y = xy[2 * i + 1];
+      float ax = 1.0f - x, ay = 1.0f - y;
+      double pair = 2.0 * (((x * x + y * y) <= 1.0f) +
+                           ((ax * ax + ay * ay) <= 1.0f));
+      sum += pair;
+      sum_sq += pair * pair;
+    }
+    done += n;
+  }
+
+  double mean = sum / pairs;
+  double variance = 0.0;
+  if (pairs > 1) {
+    variance = (sum_sq / pairs - mean * mean) * pairs / (pairs - 1) / pairs;
+  }
+  AddEstimate((long)rank, count, 2 * pairs, mean, variance);
+  return NULL;
+}
+
+// Importance sampling: π = ∫ 4 sqrt(1 - x^2) dx over [0, 1], with x drawn
+// from the density g(x) = (4 - 2x) / 3, which leans towards small x like
+// the integrand does.  Inverting the CDF (4x - x^2) / 3 gives
+// x = 2 - sqrt(4 - 3u), and each point scores f(x) / g(x).
+void* MonteCarloPiImportance(void* rank) {
+  double u[MC_CHUNK];
+  long long first, count;
+  double sum = 0.0, sum_sq = 0.0;
+
+  GetThreadRange((long)rank, &first, &count);
+  if (count == 0) {  // Still takes part in combining the totals
+    AddEstimate((long)rank, 0, 0, 0.0, 0.0);
+    return NULL;
+  }
+
+  for (long long done = 0; done < count;) {
+    int n = count - done < MC_CHUNK ? (int)(count - done) : MC_CHUNK;
+    philox_fill_double(MC_SEED, first + done, u, n);
+    for (int i = 0; i < n; i++) {
+      double x = 2.0 - sqrt(4.0 - 3.0 * u[i]);
+      double score = 12.0 * sqrt(1.0 - x * x) / (4.0 - 2.0 * x);
+      sum += score;
+      sum_sq += score * score;
+    }
+    done += n;
+  }
+
+  double mean = sum / count;
+  double variance = 0.0;
+  if (count > 1) {
+    variance = (sum_sq / count - mean * mean) * count / (count - 1) / count;
+  }
+  AddEstimate((long)rank, count, count, mean, variance);
+  return NULL;
+}
+
+// Worker of the 'adaptive' mode: claims batches of MC_BATCH points until
+// the budget is used up or the coordinator raises stop, and publishes the
+// hits of each batch in its own slot of batch_hits
+void* MonteCarloPiAdaptive(void* rank) {
+  float xy[2 * MC_CHUNK];
+
+  while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+    long long batch =
+        atomic_fetch_add_explicit(&next_batch, 1, memory_order_relaxed);
+    if (batch >= batch_count) break;
+
+    long long first = batch * MC_BATCH;
+    long long count = total_points - first < MC_BATCH ? total_points - first
+                                                      : MC_BATCH;
+    int hits = 0;
+    while (count > 0 && !atomic_load_explicit(&stop, memory_order_relaxed)) {
+      int n = count < MC_CHUNK ? (int)count : MC_CHUNK;
+      philox_fill_float(MC_SEED, 2 * first, xy, 2 * n);
+      hits += CountInCircle(xy, n);
+      first += n;
+      count -= n;
+    }
+    if (count == 0) {
+      atomic_store_explicit(&batch_hits[batch], hits, memory_order_release);
+    }
+  }
 
   return NULL;
 }
 
+// Run by the main thread while the workers are busy: folds the published
+// batches in index order into the running estimate and its variance, and
+// stops the workers once the confidence interval is within the tolerance.
+// Since batches are folded in order the stopping point, and so the
+// estimate, do not depend on the number of threads.
+double AdaptiveCoordinator(double* half_width_p, long long* points_used_p) {
+  const struct timespec pause = {0, 50000};
+  double z = NormalQuantile(confidence);
+  long long hits = 0, n = 0;
+  double pi = 0.0, half_width = INFINITY;
+
+  for (long long b = 0; b < batch_count; b++) {
+    int batch = atomic_load_explicit(&batch_hits[b], memory_order_acquire);
+    while (batch < 0) {
+      nanosleep(&pause, NULL);
+      batch = atomic_load_explicit(&batch_hits[b], memory_order_acquire);
+    }
+    hits += batch;
+    n += total_points - b * MC_BATCH < MC_BATCH ? total_points - b * MC_BATCH
+                                                : MC_BATCH;
+
+    // Each point contributes 4 * [inside] to the estimate of π
+    double p = (double)hits / n;
+    pi = 4 * p;
+    if (n > 1) {
+      double variance = 16 * p * (1 - p) * n / (n - 1);
+      half_width = z * sqrt(variance / n);
+    }
+    if (b + 1 >= MC_MIN_BATCHES && half_width <= tolerance) break;
+  }
+  atomic_store_explicit(&stop, 1, memory_order_relaxed);
+
+  *half_width_p = half_width;
+  *points_used_p = n;
+  return pi;
+}
+
+// Indicator of the unit ball, as an mc_integrate integrand
+static void UnitBall(const double* x, int dim, int n, double* values,
+                     void* arg) {
+  for (int i = 0; i < n; i++) {
+    double r2 = 0.0;
+    for (int d = 0; d < dim; d++) r2 += x[i * dim + d] * x[i * dim + d];
+    values[i] = r2 <= 1.0;
+  }
+}
+
+// Volume of the unit ball in dim dimensions by integrating its indicator
+// over [-1, 1]^dim with the general engine; for dim = 2 this is π
+int UnitBallVolume(int dim, mc_sampler_t sampler) {
+  double* lower = malloc(dim > 0 ? dim * sizeof(double) : 1);
+  double* upper = malloc(dim > 0 ? dim * sizeof(double) : 1);
+  for (int d = 0; d < dim; d++) {
+    lower[d] = -1.0;
+    upper[d] = 1.0;
+  }
+  mc_problem_t problem = {dim,  lower,   upper,  UnitBall,
+                          NULL, sampler, MC_SEED};
+  mc_result_t result;
+
+  double start = GetTime();
+  int status = mc_integrate(&problem, thread_count, total_points, &result);
+  double finish = GetTime();
+  free(lower);
+  free(upper);
+  if (status != 0) {
+    fprintf(stderr, "Error: Invalid dimension or sampler for %d dimensions.\n",
+            dim);
+    return 1;
+  }
+
+  double exact = pow(M_PI, dim / 2.0) / tgamma(dim / 2.0 + 1);
+  if (dim == 2) {
+    printf("Parallel π estimate: %f\n", result.estimate);
+  }
+  printf("Parallel time: %f seconds\n", finish - start);
+  printf("Volume of the unit %d-ball: %.8f +/- %.2e (exact %.8f)\n", dim,
+         result.estimate, result.std_error, exact);
+  return 0;
+}
+
+// z such that P(|Z| <= z) = confidence for a standard normal Z
+double NormalQuantile(double confidence) {
+  double low = 0.0, high = 40.0;
+  for (int i = 0; i < 100; i++) {
+    double mid = 0.5 * (low + high);
+    if (erf(mid / sqrt(2.0)) < confidence) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return 0.5 * (low + high);
+}
+
 double MonteCarloPiSequential(long long total_points) {
   long long points_in_circle = 0;
   for (long long i = 0; i < total_points; i++) {
@@ -101,6 +643,21 @@ double MonteCarloPiSequential(long long total_points) {
   return 4 * ((double)points_in_circle / total_points);
 }
 
+// Contiguous block of points for a thread, with the remainder spread over
+// the first threads as in MonteCarloPiParallel
+void GetThreadRange(long rank, long long* first_p, long long* count_p) {
+  long long quotient = total_points / thread_count;
+  long long remainder = total_points % thread_count;
+
+  if (rank < remainder) {
+    *count_p = quotient + 1;
+    *first_p = rank * *count_p;
+  } else {
+    *count_p = quotient;
+    *first_p = rank * quotient + remainder;
+  }
+}
+
 double GetTime() {
   struct timespec time;
   clock_gettime(CLOCK_MONOTONIC, &time);
@@ -1,10 +1,14 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "locks.h"
 
 // Global variables
 int threads_count;
-pthread_mutex_t mutex;
+lock_t lock;                   // Lock guarding value
+int contended = 0;             // Take the lock on every iteration
 unsigned long long value = 0;
 unsigned long long ITERATIONS;
 
@@ -16,24 +20,54 @@ void* increase_value(void* rank) {
   unsigned long long my_last_i =
       (my_rank == threads_count - 1) ? ITERATIONS : my_first_i + my_n;
   unsigned long long my_value = 0;  // Local counter for this thread
+  lock_node_t node;                 // This thread's queue node
 
-  for (unsigned long long i = my_first_i; i < my_last_i; i++) {
-    my_value++;
-  }
+  lock_node_init(&node);
+
+  if (contended) {
+    // Every increment goes through the lock, so the threads compete for
+    // it on each iteration
+    for (unsigned long long i = my_first_i; i < my_last_i; i++) {
+      lock_lock(&lock, &node);
+      value++;
+      lock_unlock(&lock, &node);
+    }
+  } else {
+    for (unsigned long long i = my_first_i; i < my_last_i; i++) {
+      my_value++;
+    }
 
-  // Update the shared counter safely using a mutex
-  pthread_mutex_lock(&mutex);
-  value += my_value;
-  pthread_mutex_unlock(&mutex);
+    // Update the shared counter safely using the lock
+    lock_lock(&lock, &node);
+    value += my_value;
+    lock_unlock(&lock, &node);
+  }
 
+  lock_node_destroy(&node);
   return NULL;
 }
 
 int main(int argc, char* argv[]) {
-  if (argc != 3) {
-    fprintf(stderr, "Usage: %s <number_of_threads> <iterations>\n", argv[0]);
+  lock_kind_t kind = LOCK_MUTEX;
+
+  if (argc < 3 || argc > 5) {
+    fprintf(stderr,
+            "Usage: %s <number_of_threads> <iterations> "
+            "[mutex|ttas|ticket|mcs|clh] [contended]\n",
+            argv[0]);
     return EXIT_FAILURE;
   }
+  if (argc >= 4 && lock_kind_parse(argv[3], &kind) != 0) {
+    fprintf(stderr, "Error: Unknown lock '%s'.\n", argv[3]);
+    return EXIT_FAILURE;
+  }
+  if (argc == 5) {
+    if (strcmp(argv[4], "contended") != 0) {
+      fprintf(stderr, "Error: Unknown mode '%s'.\n", argv[4]);
+      return EXIT_FAILURE;
+    }
+    contended = 1;
+  }
 
   threads_count = strtol(argv[1], NULL, 10);
   ITERATIONS = strtoull(argv[2], NULL, 10);
@@ -47,7 +81,10 @@ int main(int argc, char* argv[]) {
   // Allocate resources for threads and thread indices
   pthread_t* threads = malloc(threads_count * sizeof(pthread_t));
   long* thread_indices = malloc(threads_count * sizeof(long));
-  pthread_mutex_init(&mutex, NULL);
+  if (lock_init(&lock, kind) != 0) {
+    fprintf(stderr, "Error: Could not initialize the lock.\n");
+    return EXIT_FAILURE;
+  }
 
   // Create threads
   for (long i = 0; i < threads_count; i++) {
@@ -61,7 +98,7 @@ int main(int argc, char* argv[]) {
   }
 
   // Clean up resources
-  pthread_mutex_destroy(&mutex);
+  lock_destroy(&lock);
   free(threads);
   free(thread_indices);
 
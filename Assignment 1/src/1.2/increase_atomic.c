@@ -2,9 +2,11 @@
 #include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // Global variables
 int threads_count;
+int contended = 0;  // Update value on every iteration
 _Atomic unsigned long long value = 0;
 unsigned long long ITERATIONS;
 
@@ -16,6 +18,14 @@ void* increase_value(void* rank) {
       (my_rank == threads_count - 1) ? ITERATIONS : my_first_i + my_n;
   unsigned long long my_value = 0;
 
+  if (contended) {
+    // Every increment is an atomic read-modify-write on the shared line
+    for (unsigned long long i = my_first_i; i < my_last_i; i++) {
+      atomic_fetch_add(&value, 1);
+    }
+    return NULL;
+  }
+
   for (unsigned long long i = my_first_i; i < my_last_i; i++) {
     my_value++;  // Increment the thread-local counter
   }
@@ -27,10 +37,18 @@ void* increase_value(void* rank) {
 }
 
 int main(int argc, char* argv[]) {
-  if (argc != 3) {
-    fprintf(stderr, "Usage: %s <number_of_threads> <iterations>\n", argv[0]);
+  if (argc < 3 || argc > 4) {
+    fprintf(stderr, "Usage: %s <number_of_threads> <iterations> [contended]\n",
+            argv[0]);
     return EXIT_FAILURE;
   }
+  if (argc == 4) {
+    if (strcmp(argv[3], "contended") != 0) {
+      fprintf(stderr, "Error: Unknown mode '%s'.\n", argv[3]);
+      return EXIT_FAILURE;
+    }
+    contended = 1;
+  }
 
   threads_count = strtol(argv[1], NULL, 10);
   ITERATIONS = strtoull(argv[2], NULL, 10);
@@ -0,0 +1,65 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sharded_counter.h"
+
+// Global variables
+int threads_count;
+sharded_counter_t value;  // One padded slot per thread
+unsigned long long ITERATIONS;
+
+// Every iteration adds to the shared counter, like the 'contended' mode of
+// increase and increase_atomic, but each thread only writes its own slot
+void* increase_value(void* rank) {
+  long my_rank = *(long*)rank;
+  unsigned long long my_n = ITERATIONS / threads_count;
+  unsigned long long my_first_i = my_n * my_rank;
+  unsigned long long my_last_i =
+      (my_rank == threads_count - 1) ? ITERATIONS : my_first_i + my_n;
+
+  for (unsigned long long i = my_first_i; i < my_last_i; i++) {
+    sc_add(&value, my_rank, 1);
+  }
+
+  return NULL;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <number_of_threads> <iterations>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  threads_count = strtol(argv[1], NULL, 10);
+  ITERATIONS = strtoull(argv[2], NULL, 10);
+
+  if (threads_count <= 0 || ITERATIONS <= 0) {
+    fprintf(stderr,
+            "Error: Number of threads and iterations must be positive.\n");
+    return EXIT_FAILURE;
+  }
+
+  pthread_t* threads = malloc(threads_count * sizeof(pthread_t));
+  long* thread_indices = malloc(threads_count * sizeof(long));
+  if (sc_init(&value, threads_count) != 0) {
+    fprintf(stderr, "Error: Could not allocate the counter.\n");
+    return EXIT_FAILURE;
+  }
+
+  for (long i = 0; i < threads_count; i++) {
+    thread_indices[i] = i;
+    pthread_create(&threads[i], NULL, increase_value, &thread_indices[i]);
+  }
+
+  for (long i = 0; i < threads_count; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  printf("The value is %llu\n", sc_sum(&value));
+
+  sc_destroy(&value);
+  free(threads);
+  free(thread_indices);
+  return 0;
+}
@@ -3,10 +3,60 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "perf_counters.h"
+#include "reduce.h"
+#include "timer.h"
+
+#define CACHE_LINE 64
+#define PAGE_SIZE 4096
+
+// Where each thread's counter lives
+typedef enum {
+  LAYOUT_PACKED,  // Adjacent slots of one buffer: 8 threads share a line
+  LAYOUT_PADDED,  // One cache line per slot
+  LAYOUT_LOCAL,   // Count in a local variable, store to the slot once
+  LAYOUT_NUMA     // Own page per thread, first touched (so placed) by it
+} layout_t;
+
+typedef struct {
+  unsigned long long value;
+} __attribute__((aligned(CACHE_LINE))) padded_item_t;
+
+const char* LAYOUT_NAMES[] = {"packed", "padded", "local", "numa"};
+
 // Global variables
 int threads_count;
-unsigned long long* array;
-const unsigned long long ITERATIONS = 24100654080;
+layout_t layout = LAYOUT_PACKED;
+unsigned long long* array;         // packed and local layouts
+padded_item_t* padded_array;       // padded layout
+unsigned long long** numa_items;   // numa layout, allocated by the threads
+unsigned long long ITERATIONS = 24100654080;
+unsigned long long sum = 0;        // Total of the counters
+#ifndef BASELINE_COMBINE
+reducer_t reducer;                 // Combines the counters into sum
+#endif
+
+// Returns the counter of thread index in the current layout
+unsigned long long* item(long index) {
+  switch (layout) {
+    case LAYOUT_PADDED:
+      return &padded_array[index].value;
+    case LAYOUT_NUMA:
+      return numa_items[index];
+    default:
+      return &array[index];
+  }
+}
+
+// Adds the thread's counter to sum with a reducer_t tree (reduce.c); every
+// thread must call it.  With BASELINE_COMBINE main adds up the counters
+// after the join instead.  Counts below 2^53 are exact as doubles.
+void combine_item(long index) {
+#ifndef BASELINE_COMBINE
+  double total = reducer_combine(&reducer, index, (double)*item(index));
+  if (index == 0) sum = (unsigned long long)total;
+#endif
+}
 
 // Function executed by each thread
 void* increase_array_item(void* index) {
@@ -16,21 +66,58 @@ void* increase_array_item(void* index) {
   long my_last_i =
       (my_index == threads_count - 1) ? ITERATIONS : my_first_i + my_n;
 
+  if (layout == LAYOUT_LOCAL) {
+    unsigned long long my_sum = 0;
+    for (unsigned long long i = my_first_i; i < my_last_i; i++) {
+      my_sum++;
+    }
+    array[my_index] = my_sum;
+    combine_item(my_index);
+    return NULL;
+  }
+
+  if (layout == LAYOUT_NUMA) {
+    // The first write places the page on this thread's NUMA node
+    numa_items[my_index] = aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+    *numa_items[my_index] = 0;
+  }
+
+  // volatile keeps every increment a load and store of the shared slot,
+  // whatever the optimization level
+  volatile unsigned long long* my_item = item(my_index);
   for (unsigned long long i = my_first_i; i < my_last_i; i++) {
-    array[my_index]++;
+    (*my_item)++;
   }
+  combine_item(my_index);
 
   return NULL;
 }
 
 int main(int argc, char* argv[]) {
   // Validate the number of arguments
-  if (argc != 2) {
-    fprintf(stderr, "Usage: %s <number_of_threads>\n", argv[0]);
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr,
+            "Usage: %s <number_of_threads> [packed|padded|local|numa] "
+            "[iterations]\n",
+            argv[0]);
     return EXIT_FAILURE;
   }
 
   threads_count = strtol(argv[1], NULL, 10);
+  if (argc >= 3) {
+    int found = 0;
+    for (int l = 0; l < 4; l++) {
+      if (strcmp(argv[2], LAYOUT_NAMES[l]) == 0) {
+        layout = (layout_t)l;
+        found = 1;
+      }
+    }
+    if (!found) {
+      fprintf(stderr, "Error: Unknown layout '%s'.\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (argc == 4) ITERATIONS = strtoull(argv[3], NULL, 10);
 
   // Validate the number of threads
   if (threads_count <= 0 || threads_count > ITERATIONS) {
@@ -39,11 +126,27 @@ int main(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
-  // Allocate memory for threads, indices, and the array
+  // Allocate memory for threads, indices, and the counters
   pthread_t* threads = malloc(threads_count * sizeof(pthread_t));
   long* thread_indices = malloc(threads_count * sizeof(long));
   array = malloc(threads_count * sizeof(unsigned long long));
   memset(array, 0, threads_count * sizeof(unsigned long long));
+  padded_array = aligned_alloc(CACHE_LINE, threads_count * sizeof(padded_item_t));
+  memset(padded_array, 0, threads_count * sizeof(padded_item_t));
+  numa_items = calloc(threads_count, sizeof(unsigned long long*));
+#ifndef BASELINE_COMBINE
+  if (reducer_init(&reducer, threads_count, &REDUCE_SUM, 0) != 0) {
+    fprintf(stderr, "Error: Could not allocate the reducer.\n");
+    return EXIT_FAILURE;
+  }
+#endif
+
+  // Counters are inherited by the threads, so open them first
+  perf_counters_t counters;
+  double start, finish;
+  pc_open(&counters);
+  GET_TIME(start);
+  pc_start(&counters);
 
   // Create threads
   for (long i = 0; i < threads_count; i++) {
@@ -56,18 +159,35 @@ int main(int argc, char* argv[]) {
     pthread_join(threads[i], NULL);
   }
 
+  pc_stop(&counters);
+  GET_TIME(finish);
+
+#ifdef BASELINE_COMBINE
   // Calculate the sum of all elements in the array
-  unsigned long long sum = 0;
   for (int i = 0; i < threads_count; i++) {
-    sum += array[i];
+    sum += *item(i);
   }
+#endif
 
   printf("The sum is: %llu\n", sum);
+  printf("Layout: %s\n", LAYOUT_NAMES[layout]);
+  printf("Elapsed time: %f seconds (%.3f ns per increment)\n",
+         finish - start, (finish - start) * 1e9 / ITERATIONS);
+  pc_print(&counters, ITERATIONS, stdout);
+  pc_close(&counters);
 
   // Free allocated memory
+  for (int i = 0; i < threads_count; i++) {
+    free(numa_items[i]);
+  }
+  free(numa_items);
+  free(padded_array);
   free(threads);
   free(thread_indices);
   free(array);
+#ifndef BASELINE_COMBINE
+  reducer_destroy(&reducer);
+#endif
 
   return 0;
-}
\ No newline at end of file
+}
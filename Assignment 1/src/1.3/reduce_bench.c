@@ -0,0 +1,189 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reduce.h"
+#include "timer.h"
+
+#define PASSES 5  // Timed passes over the array; the best one is reported
+
+// How the per-thread results are combined
+typedef enum {
+  COMBINE_MUTEX,   // Shared total under a mutex, as in monte_carlo_pi.c
+  COMBINE_SERIAL,  // Per-thread array summed by main, as in array_sum.c
+  COMBINE_TREE,    // reducer_t combining tree
+  COMBINE_NUMA     // reducer_t combining tree, node by node
+} combine_t;
+
+const char* COMBINE_NAMES[] = {"mutex", "serial", "tree", "numa"};
+
+// Global variables
+int threads_count;
+size_t n;                  // Number of doubles in the array
+double* array;
+const reduce_op_t* op;
+combine_t combine = COMBINE_TREE;
+pthread_mutex_t mutex;
+pthread_barrier_t barrier;
+reducer_t reducer;
+double total;              // Result of the mutex and serial combines
+double* partial;           // Per-thread results of the serial combine
+double pass_time[PASSES];
+
+// A user-defined operator: the largest absolute value
+double MaxAbs(double a, double b) {
+  if (a < 0) a = -a;
+  if (b < 0) b = -b;
+  return a > b ? a : b;
+}
+const reduce_op_t REDUCE_MAX_ABS = {MaxAbs, 0.0};
+
+void* reduce_array(void* index) {
+  long my_index = *(long*)index;
+  size_t quotient = n / threads_count, remainder = n % threads_count;
+  size_t my_n = quotient + ((size_t)my_index < remainder);
+  size_t my_first =
+      my_index * quotient + ((size_t)my_index < remainder ? my_index : remainder);
+  double start = 0, finish;
+
+  // Each thread initializes its own block, so with first-touch placement
+  // the block lives on the thread's NUMA node
+  for (size_t i = my_first; i < my_first + my_n; i++) {
+    array[i] = (i % 1000) * 0.5 - 200.0;
+  }
+
+  for (int pass = 0; pass < PASSES; pass++) {
+    if (my_index == 0) total = op->identity;
+    pthread_barrier_wait(&barrier);
+    if (my_index == 0) GET_TIME(start);
+
+    double my_result = reduce_local(array + my_first, my_n, op);
+
+    switch (combine) {
+      case COMBINE_MUTEX:
+        pthread_mutex_lock(&mutex);
+        total = op->combine(total, my_result);
+        pthread_mutex_unlock(&mutex);
+        pthread_barrier_wait(&barrier);
+        break;
+      case COMBINE_SERIAL:
+        partial[my_index] = my_result;
+        pthread_barrier_wait(&barrier);
+        if (my_index == 0) {
+          for (int i = 0; i < threads_count; i++) {
+            total = op->combine(total, partial[i]);
+          }
+        }
+        break;
+      default:
+        my_result = reducer_combine(&reducer, my_index, my_result);
+        if (my_index == 0) total = my_result;
+        break;
+    }
+
+    if (my_index == 0) {
+      GET_TIME(finish);
+      pass_time[pass] = finish - start;
+    }
+  }
+
+  return NULL;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 3 || argc > 5) {
+    fprintf(stderr,
+            "Usage: %s <number_of_threads> <number_of_elements> "
+            "[sum|min|max|maxabs] [mutex|serial|tree|numa]\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  threads_count = strtol(argv[1], NULL, 10);
+  n = strtoull(argv[2], NULL, 10);
+  op = &REDUCE_SUM;
+  if (argc >= 4) {
+    if (strcmp(argv[3], "min") == 0) {
+      op = &REDUCE_MIN;
+    } else if (strcmp(argv[3], "max") == 0) {
+      op = &REDUCE_MAX;
+    } else if (strcmp(argv[3], "maxabs") == 0) {
+      op = &REDUCE_MAX_ABS;
+    } else if (strcmp(argv[3], "sum") != 0) {
+      fprintf(stderr, "Error: Unknown operator '%s'.\n", argv[3]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (argc == 5) {
+    int found = 0;
+    for (int c = 0; c < 4; c++) {
+      if (strcmp(argv[4], COMBINE_NAMES[c]) == 0) {
+        combine = (combine_t)c;
+        found = 1;
+      }
+    }
+    if (!found) {
+      fprintf(stderr, "Error: Unknown combine '%s'.\n", argv[4]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (threads_count <= 0 || n == 0) {
+    fprintf(stderr,
+            "Error: Number of threads and elements must be positive.\n");
+    return EXIT_FAILURE;
+  }
+
+  pthread_t* threads = malloc(threads_count * sizeof(pthread_t));
+  long* thread_indices = malloc(threads_count * sizeof(long));
+  partial = malloc(threads_count * sizeof(double));
+  array = malloc(n * sizeof(double));
+  if (array == NULL) {
+    fprintf(stderr, "Error: Could not allocate %zu doubles.\n", n);
+    return EXIT_FAILURE;
+  }
+  pthread_mutex_init(&mutex, NULL);
+  pthread_barrier_init(&barrier, NULL, threads_count);
+  if (reducer_init(&reducer, threads_count, op, combine == COMBINE_NUMA) !=
+      0) {
+    fprintf(stderr, "Error: Could not allocate the reducer.\n");
+    return EXIT_FAILURE;
+  }
+
+  for (long i = 0; i < threads_count; i++) {
+    thread_indices[i] = i;
+    pthread_create(&threads[i], NULL, reduce_array, &thread_indices[i]);
+  }
+  for (long i = 0; i < threads_count; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  // Serial reference with the same vectorized loop
+  double start, finish;
+  GET_TIME(start);
+  double expected = reduce_local(array, n, op);
+  GET_TIME(finish);
+
+  double best = pass_time[0];
+  for (int pass = 1; pass < PASSES; pass++) {
+    if (pass_time[pass] < best) best = pass_time[pass];
+  }
+  double gigabytes = n * sizeof(double) / 1e9;
+
+  printf("The result is: %f (serial: %f)\n", total, expected);
+  printf("Combine: %s\n", COMBINE_NAMES[combine]);
+  printf("Parallel time: %f seconds (%.2f GB/s, best of %d)\n", best,
+         gigabytes / best, PASSES);
+  printf("Serial time: %f seconds (%.2f GB/s)\n", finish - start,
+         gigabytes / (finish - start));
+
+  reducer_destroy(&reducer);
+  pthread_barrier_destroy(&barrier);
+  pthread_mutex_destroy(&mutex);
+  free(array);
+  free(partial);
+  free(threads);
+  free(thread_indices);
+  return 0;
+}
@@ -0,0 +1,169 @@
+/* File:     harris_list.c
+ *
+ * Purpose:  lock-free sorted linked list set backend for rw_lock.c
+ *
+ * Notes:
+ * 1.  The algorithm is Harris' list ("A pragmatic implementation of
+ *     non-blocking linked-lists", 2001) in the form of Michael ("High
+ *     performance dynamic lock-free hash tables and list-based sets",
+ *     2002).  The low bit of a node's next pointer marks the node as
+ *     logically deleted; a key is in the set iff its node is reachable
+ *     and unmarked.
+ * 2.  Delete marks the node (the thread whose mark succeeds deleted the
+ *     key), then tries to unlink it with one CAS.  If that fails, the
+ *     next Find that passes the node unlinks it.  Only the thread whose
+ *     unlinking CAS succeeds retires the node, so it is retired once.
+ * 3.  Nodes are freed through epoch-based reclamation, so a traversal may
+ *     keep reading a node that has just been unlinked.  No operation ever
+ *     waits for another thread: a preempted thread delays nobody.
+ * 4.  Member does not help unlinking and never writes shared memory.
+ */
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "epoch.h"
+#include "set_backend.h"
+
+typedef struct hm_node {
+  int key;
+  _Atomic uintptr_t next; /* Successor, low bit = mark */
+} hm_node_t;
+
+typedef struct {
+  hm_node_t* head; /* Key INT_MIN */
+  hm_node_t* tail; /* Key INT_MAX */
+  epoch_t epoch;
+} harris_list_t;
+
+#define MARKED(p) ((p)&1)
+#define UNMARK(p) ((hm_node_t*)((p) & ~(uintptr_t)1))
+
+static hm_node_t* Node_new(int key, hm_node_t* next) {
+  hm_node_t* node = malloc(sizeof(hm_node_t));
+  node->key = key;
+  atomic_init(&node->next, (uintptr_t)next);
+  return node;
+}
+
+/* Returns the first node with key >= key and sets *pred_p to the node
+ * before it, unlinking and retiring marked nodes on the way */
+static hm_node_t* Find(harris_list_t* list, int key, hm_node_t** pred_p,
+                       long rank) {
+retry:;
+  hm_node_t* pred = list->head;
+  hm_node_t* curr = UNMARK(atomic_load(&pred->next));
+  for (;;) {
+    uintptr_t succ = atomic_load(&curr->next);
+    if (MARKED(succ)) {
+      uintptr_t expected = (uintptr_t)curr;
+      if (!atomic_compare_exchange_strong(&pred->next, &expected,
+                                          (uintptr_t)UNMARK(succ))) {
+        goto retry; /* pred changed or was marked itself */
+      }
+      epoch_retire(&list->epoch, rank, curr);
+      curr = UNMARK(succ);
+    } else if (curr->key < key) {
+      pred = curr;
+      curr = UNMARK(succ);
+    } else {
+      *pred_p = pred;
+      return curr;
+    }
+  }
+}
+
+static void* Harris_create(int thread_count) {
+  harris_list_t* list = malloc(sizeof(harris_list_t));
+
+  list->tail = Node_new(INT_MAX, NULL);
+  list->head = Node_new(INT_MIN, list->tail);
+  epoch_init(&list->epoch, thread_count, free);
+  return list;
+}
+
+static int Harris_insert(void* set, int value, long rank) {
+  harris_list_t* list = set;
+  hm_node_t* node = Node_new(value, NULL);
+  hm_node_t* pred;
+
+  epoch_enter(&list->epoch, rank);
+  for (;;) {
+    hm_node_t* curr = Find(list, value, &pred, rank);
+    if (curr->key == value) {
+      epoch_exit(&list->epoch, rank);
+      free(node); /* Never published */
+      return 0;
+    }
+    atomic_store_explicit(&node->next, (uintptr_t)curr, memory_order_relaxed);
+    uintptr_t expected = (uintptr_t)curr;
+    if (atomic_compare_exchange_strong(&pred->next, &expected,
+                                       (uintptr_t)node)) {
+      break;
+    }
+  }
+  epoch_exit(&list->epoch, rank);
+  return 1;
+}
+
+static int Harris_member(void* set, int value, long rank) {
+  harris_list_t* list = set;
+  hm_node_t* curr;
+
+  epoch_enter(&list->epoch, rank);
+  curr = UNMARK(atomic_load(&list->head->next));
+  while (curr->key < value) curr = UNMARK(atomic_load(&curr->next));
+  int found = curr->key == value && !MARKED(atomic_load(&curr->next));
+  epoch_exit(&list->epoch, rank);
+  return found;
+}
+
+static int Harris_delete(void* set, int value, long rank) {
+  harris_list_t* list = set;
+  hm_node_t* pred;
+  hm_node_t* curr;
+  uintptr_t succ;
+
+  epoch_enter(&list->epoch, rank);
+  for (;;) {
+    curr = Find(list, value, &pred, rank);
+    if (curr->key != value) {
+      epoch_exit(&list->epoch, rank);
+      return 0;
+    }
+    succ = atomic_load(&curr->next);
+    if (!MARKED(succ) &&
+        atomic_compare_exchange_strong(&curr->next, &succ, succ | 1)) {
+      break;
+    }
+    /* Marked by another thread, or curr->next changed: look again */
+  }
+
+  uintptr_t expected = (uintptr_t)curr;
+  if (atomic_compare_exchange_strong(&pred->next, &expected, succ)) {
+    epoch_retire(&list->epoch, rank, curr);
+  } else {
+    Find(list, value, &pred, rank); /* Unlinks it */
+  }
+  epoch_exit(&list->epoch, rank);
+  return 1;
+}
+
+static void Harris_destroy(void* set) {
+  harris_list_t* list = set;
+  hm_node_t* curr = list->head;
+
+  /* Nodes still linked, marked or not, have not been retired */
+  while (curr != NULL) {
+    hm_node_t* next = UNMARK(atomic_load(&curr->next));
+    free(curr);
+    curr = next;
+  }
+  epoch_destroy(&list->epoch);
+  free(list);
+}
+
+const set_backend_t harris_backend = {"harris",      Harris_create,
+                                      Harris_insert, Harris_member,
+                                      Harris_delete, Harris_destroy};
@@ -0,0 +1,262 @@
+/* File:     hash_set.c
+ *
+ * Purpose:  concurrent hash set backend for rw_lock.c with lock striping
+ *           and incremental resizing
+ *
+ * Notes:
+ * 1.  Keys are hashed into buckets of singly linked chains.  The low
+ *     bits of the hash pick the stripe, whose lock guards a contiguous run
+ *     of size / HASH_STRIPES buckets; the next bits pick the bucket in the
+ *     run.  A key stays in the same stripe when the table grows.  A run
+ *     is at least one cache line of bucket heads and the stripes are
+ *     padded, so ops on different stripes share no cache line.
+ * 2.  Each stripe counts its keys, so no op touches a shared counter.
+ *     When an Insert leaves its stripe with more than HASH_LOAD keys per
+ *     bucket, the table doubles.  The resizing thread only allocates the
+ *     new table and publishes it; the keys move stripe by stripe.
+ * 3.  A stripe that is locked while behind the current table first moves
+ *     its run of the previous one (bucket j of the run splits into
+ *     buckets j and j + old run length of the new run).  After each op a thread also migrates the next
+ *     stripe in line while a resize is under way, so a resize completes
+ *     within HASH_STRIPES ops even if the keys miss most stripes.  The
+ *     thread that migrates the last stripe frees the old table, and only
+ *     then can the next resize start.
+ * 4.  The set is unordered and never shrinks.
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "set_backend.h"
+
+#define HASH_STRIPES 1024 /* Power of two */
+#define HASH_LOAD 2
+#define HASH_MIN_RUN (64 / sizeof(void*)) /* Bucket heads per cache line */
+
+typedef struct hs_node {
+  int key;
+  struct hs_node* next;
+} hs_node_t;
+
+typedef struct hs_table {
+  long size; /* Buckets */
+  unsigned gen;
+  hs_node_t** buckets;
+  struct hs_table* prev; /* Not yet fully migrated, else NULL */
+} hs_table_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  unsigned gen; /* Table generation this stripe's keys are in */
+  long count;   /* Keys in this stripe */
+} __attribute__((aligned(64))) hs_stripe_t;
+
+typedef struct {
+  hs_stripe_t stripes[HASH_STRIPES];
+  _Atomic(hs_table_t*) table;
+  _Atomic int resizing;   /* 1 from a resize's start until it completes */
+  _Atomic int unmigrated; /* Stripes still in the previous table */
+  _Atomic int help_next;  /* Next stripe to migrate after an op */
+} hash_set_t;
+
+/* Finalizer of MurmurHash3: spreads runs of consecutive keys */
+static uint32_t Hash(int key) {
+  uint32_t h = (uint32_t)key;
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+/* Index in table of the bucket of hash h */
+static long Bucket(const hs_table_t* table, uint32_t h) {
+  long run = table->size / HASH_STRIPES;
+  return (h & (HASH_STRIPES - 1)) * run + ((h / HASH_STRIPES) & (run - 1));
+}
+
+static hs_table_t* Table_new(long size, unsigned gen, hs_table_t* prev) {
+  hs_table_t* table = malloc(sizeof(hs_table_t));
+  table->size = size;
+  table->gen = gen;
+  /* Runs of a multiple of HASH_MIN_RUN buckets start on a cache line */
+  table->buckets = aligned_alloc(64, size * sizeof(hs_node_t*));
+  memset(table->buckets, 0, size * sizeof(hs_node_t*));
+  table->prev = prev;
+  return table;
+}
+
+/* Brings stripe s up to the current table; called with its lock held.
+ * Returns the current table */
+static hs_table_t* Sync_stripe(hash_set_t* set, int s) {
+  hs_stripe_t* stripe = &set->stripes[s];
+  hs_table_t* table = atomic_load_explicit(&set->table, memory_order_acquire);
+
+  if (stripe->gen == table->gen) return table;
+
+  hs_table_t* old = table->prev;
+  long run = old->size / HASH_STRIPES;
+  for (long b = s * run; b < (s + 1) * run; b++) {
+    hs_node_t* node = old->buckets[b];
+    while (node != NULL) {
+      hs_node_t* next = node->next;
+      long to = Bucket(table, Hash(node->key));
+      node->next = table->buckets[to];
+      table->buckets[to] = node;
+      node = next;
+    }
+    old->buckets[b] = NULL;
+  }
+  stripe->gen = table->gen;
+
+  if (atomic_fetch_sub(&set->unmigrated, 1) == 1) {
+    table->prev = NULL;
+    free(old->buckets);
+    free(old);
+    atomic_store(&set->resizing, 0);
+  }
+  return table;
+}
+
+/* Doubles the table if it still has size buckets and no resize is
+ * under way */
+static void Try_resize(hash_set_t* set, long size) {
+  int idle = 0;
+
+  if (!atomic_compare_exchange_strong(&set->resizing, &idle, 1)) return;
+  /* Nothing is freed while resizing is 1 */
+  hs_table_t* table = atomic_load(&set->table);
+  if (table->size != size) {
+    atomic_store(&set->resizing, 0);
+    return;
+  }
+  atomic_store(&set->unmigrated, HASH_STRIPES);
+  atomic_store_explicit(&set->table,
+                        Table_new(2 * size, table->gen + 1, table),
+                        memory_order_release);
+  atomic_store(&set->help_next, 0);
+}
+
+/* Migrates one more stripe of a resize under way */
+static void Help_resize(hash_set_t* set) {
+  if (!atomic_load_explicit(&set->resizing, memory_order_relaxed)) return;
+  int s = atomic_fetch_add(&set->help_next, 1);
+  if (s >= HASH_STRIPES) return;
+  pthread_mutex_lock(&set->stripes[s].lock);
+  Sync_stripe(set, s);
+  pthread_mutex_unlock(&set->stripes[s].lock);
+}
+
+static void* Hash_create(int thread_count) {
+  hash_set_t* set = aligned_alloc(64, sizeof(hash_set_t));
+
+  for (int s = 0; s < HASH_STRIPES; s++) {
+    pthread_mutex_init(&set->stripes[s].lock, NULL);
+    set->stripes[s].gen = 0;
+    set->stripes[s].count = 0;
+  }
+  atomic_init(&set->table, Table_new(HASH_STRIPES * HASH_MIN_RUN, 0, NULL));
+  atomic_init(&set->resizing, 0);
+  atomic_init(&set->unmigrated, 0);
+  atomic_init(&set->help_next, HASH_STRIPES);
+  return set;
+}
+
+static int Hash_insert(void* set_p, int value, long rank) {
+  hash_set_t* set = set_p;
+  uint32_t h = Hash(value);
+  hs_stripe_t* stripe = &set->stripes[h & (HASH_STRIPES - 1)];
+  long grow_from = 0;
+  int inserted = 0;
+
+  pthread_mutex_lock(&stripe->lock);
+  hs_table_t* table = Sync_stripe(set, h & (HASH_STRIPES - 1));
+  hs_node_t** bucket = &table->buckets[Bucket(table, h)];
+  hs_node_t* node = *bucket;
+  while (node != NULL && node->key != value) node = node->next;
+  if (node == NULL) {
+    node = malloc(sizeof(hs_node_t));
+    node->key = value;
+    node->next = *bucket;
+    *bucket = node;
+    inserted = 1;
+    if (++stripe->count > HASH_LOAD * (table->size / HASH_STRIPES)) {
+      grow_from = table->size;
+    }
+  }
+  pthread_mutex_unlock(&stripe->lock);
+
+  if (grow_from) Try_resize(set, grow_from);
+  Help_resize(set);
+  return inserted;
+}
+
+static int Hash_member(void* set_p, int value, long rank) {
+  hash_set_t* set = set_p;
+  uint32_t h = Hash(value);
+  hs_stripe_t* stripe = &set->stripes[h & (HASH_STRIPES - 1)];
+
+  pthread_mutex_lock(&stripe->lock);
+  hs_table_t* table = Sync_stripe(set, h & (HASH_STRIPES - 1));
+  hs_node_t* node = table->buckets[Bucket(table, h)];
+  while (node != NULL && node->key != value) node = node->next;
+  pthread_mutex_unlock(&stripe->lock);
+
+  Help_resize(set);
+  return node != NULL;
+}
+
+static int Hash_delete(void* set_p, int value, long rank) {
+  hash_set_t* set = set_p;
+  uint32_t h = Hash(value);
+  hs_stripe_t* stripe = &set->stripes[h & (HASH_STRIPES - 1)];
+  int deleted = 0;
+
+  pthread_mutex_lock(&stripe->lock);
+  hs_table_t* table = Sync_stripe(set, h & (HASH_STRIPES - 1));
+  hs_node_t** link = &table->buckets[Bucket(table, h)];
+  while (*link != NULL && (*link)->key != value) link = &(*link)->next;
+  if (*link != NULL) {
+    hs_node_t* node = *link;
+    *link = node->next;
+    free(node);
+    stripe->count--;
+    deleted = 1;
+  }
+  pthread_mutex_unlock(&stripe->lock);
+
+  Help_resize(set);
+  return deleted;
+}
+
+static void Free_buckets(hs_table_t* table) {
+  for (long b = 0; b < table->size; b++) {
+    hs_node_t* node = table->buckets[b];
+    while (node != NULL) {
+      hs_node_t* next = node->next;
+      free(node);
+      node = next;
+    }
+  }
+  free(table->buckets);
+  free(table);
+}
+
+static void Hash_destroy(void* set_p) {
+  hash_set_t* set = set_p;
+  hs_table_t* table = atomic_load(&set->table);
+
+  /* Unmigrated stripes still have their keys in the previous table */
+  if (table->prev != NULL) Free_buckets(table->prev);
+  Free_buckets(table);
+  for (int s = 0; s < HASH_STRIPES; s++) {
+    pthread_mutex_destroy(&set->stripes[s].lock);
+  }
+  free(set);
+}
+
+const set_backend_t hash_backend = {"hash",      Hash_create, Hash_insert,
+                                    Hash_member, Hash_delete, Hash_destroy};
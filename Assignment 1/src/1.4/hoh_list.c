@@ -0,0 +1,119 @@
+/* File:     hoh_list.c
+ *
+ * Purpose:  sorted linked list set backend for rw_lock.c with one mutex
+ *           per node and hand-over-hand locking
+ *
+ * Notes:
+ * 1.  Every operation locks the head sentinel, then walks the list holding
+ *     at most two locks: it locks the next node before unlocking the
+ *     previous one (lock coupling), so no other thread can unlink or
+ *     insert between the two.  Threads working on different parts of the
+ *     list proceed in parallel; a writer only blocks the threads that
+ *     have to pass its position.
+ * 2.  All threads take the locks in list order, so there is no deadlock.
+ * 3.  Delete holds the locks of both the predecessor and the node, and a
+ *     thread can only wait for the node's lock while holding the
+ *     predecessor's, so the node can be freed right after unlocking it.
+ */
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "set_backend.h"
+
+typedef struct hoh_node {
+  int data;
+  struct hoh_node* next;
+  pthread_mutex_t mutex;
+} hoh_node_t;
+
+static hoh_node_t* Node_new(int data, hoh_node_t* next) {
+  hoh_node_t* node = malloc(sizeof(hoh_node_t));
+  node->data = data;
+  node->next = next;
+  pthread_mutex_init(&node->mutex, NULL);
+  return node;
+}
+
+static void Node_free(hoh_node_t* node) {
+  pthread_mutex_destroy(&node->mutex);
+  free(node);
+}
+
+/* Locks the last node with data < value and its successor (if any);
+ * returns the predecessor, *curr_p is the successor or NULL */
+static hoh_node_t* Find(hoh_node_t* head, int value, hoh_node_t** curr_p) {
+  hoh_node_t* pred = head;
+  hoh_node_t* curr;
+
+  pthread_mutex_lock(&pred->mutex);
+  curr = pred->next;
+  if (curr != NULL) pthread_mutex_lock(&curr->mutex);
+  while (curr != NULL && curr->data < value) {
+    pthread_mutex_unlock(&pred->mutex);
+    pred = curr;
+    curr = curr->next;
+    if (curr != NULL) pthread_mutex_lock(&curr->mutex);
+  }
+  *curr_p = curr;
+  return pred;
+}
+
+static void Unlock_pair(hoh_node_t* pred, hoh_node_t* curr) {
+  if (curr != NULL) pthread_mutex_unlock(&curr->mutex);
+  pthread_mutex_unlock(&pred->mutex);
+}
+
+static void* Hoh_create(int thread_count) {
+  /* The head sentinel is never removed and holds no key */
+  return Node_new(INT_MIN, NULL);
+}
+
+static int Hoh_insert(void* set, int value, long rank) {
+  hoh_node_t* curr;
+  hoh_node_t* pred = Find(set, value, &curr);
+  int rv = 0;
+
+  if (curr == NULL || curr->data > value) {
+    pred->next = Node_new(value, curr);
+    rv = 1;
+  }
+  Unlock_pair(pred, curr);
+  return rv;
+}
+
+static int Hoh_member(void* set, int value, long rank) {
+  hoh_node_t* curr;
+  hoh_node_t* pred = Find(set, value, &curr);
+  int rv = curr != NULL && curr->data == value;
+
+  Unlock_pair(pred, curr);
+  return rv;
+}
+
+static int Hoh_delete(void* set, int value, long rank) {
+  hoh_node_t* curr;
+  hoh_node_t* pred = Find(set, value, &curr);
+
+  if (curr != NULL && curr->data == value) {
+    pred->next = curr->next;
+    Unlock_pair(pred, curr);
+    Node_free(curr);
+    return 1;
+  }
+  Unlock_pair(pred, curr);
+  return 0;
+}
+
+static void Hoh_destroy(void* set) {
+  hoh_node_t* curr = set;
+
+  while (curr != NULL) {
+    hoh_node_t* next = curr->next;
+    Node_free(curr);
+    curr = next;
+  }
+}
+
+const set_backend_t hoh_backend = {"hoh",      Hoh_create, Hoh_insert,
+                                   Hoh_member, Hoh_delete, Hoh_destroy};
@@ -0,0 +1,281 @@
+/* File:     mvcc_list.c
+ *
+ * Purpose:  multi-version sorted linked list set backend for rw_lock.c,
+ *           with range scans that read a consistent snapshot
+ *
+ * Notes:
+ * 1.  Every node is one version of a key: it holds the commit timestamps
+ *     of the Insert that created it and of the Delete that ended it
+ *     (MV_LIVE until then).  A writer takes write_mutex, stamps its change
+ *     with clock + 1, links it with a release store and commits by
+ *     storing the new timestamp to clock.  Nodes of the same key are
+ *     newest first.
+ * 2.  Member and scan take no lock.  They read clock as their snapshot s
+ *     and see exactly the versions with ins_ts <= s < del_ts, so a scan
+ *     counts the set as it was at s however long it takes, and writers
+ *     never wait for it.
+ * 3.  A reader announces the clock value it saw in its own slot, then
+ *     reads clock again for its snapshot.  The collector reads clock
+ *     before the slots and takes the minimum as its horizon.  If it missed
+ *     an announcement, the reader's second read is at least the collector's
+ *     clock value, so a horizon never passes a snapshot in use.
+ * 4.  A background collector thread walks the list in chunks of
+ *     MVCC_GC_CHUNK nodes under write_mutex.  It unlinks versions deleted
+ *     at or before the horizon, which no snapshot can see, and retires
+ *     them to epoch-based reclamation (epoch.c), since readers may still
+ *     be passing through them.  It sleeps MVCC_GC_PAUSE_NS at the end of
+ *     the list.
+ */
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "epoch.h"
+#include "set_backend.h"
+
+#define MV_LIVE UINT64_MAX /* del_ts of a version not deleted */
+#define MV_IDLE UINT64_MAX /* Snapshot slot of a thread not reading */
+#define MVCC_GC_CHUNK 1024
+#define MVCC_GC_PAUSE_NS 1000000
+
+typedef struct mv_node {
+  int key;
+  uint64_t ins_ts;         /* Commit timestamp of the Insert */
+  _Atomic uint64_t del_ts; /* Commit timestamp of the Delete, or MV_LIVE */
+  _Atomic(struct mv_node*) next;
+} mv_node_t;
+
+typedef struct {
+  _Atomic uint64_t ts;
+} __attribute__((aligned(64))) mv_snapshot_t;
+
+typedef struct {
+  mv_node_t* head; /* Key INT_MIN, then a tail of key INT_MAX */
+  pthread_mutex_t write_mutex; /* Writers and the collector */
+  _Atomic uint64_t clock;      /* Timestamp of the last commit */
+  int thread_count;
+  mv_snapshot_t* snapshots; /* One per rank */
+  epoch_t epoch;            /* Rank thread_count is the collector */
+  pthread_t collector;
+  _Atomic int stop;
+  mv_node_t* gc_pred; /* Where the collector resumes */
+} mvcc_list_t;
+
+static mv_node_t* Node_new(int key, uint64_t ins_ts, mv_node_t* next) {
+  mv_node_t* node = malloc(sizeof(mv_node_t));
+  node->key = key;
+  node->ins_ts = ins_ts;
+  atomic_init(&node->del_ts, MV_LIVE);
+  atomic_init(&node->next, next);
+  return node;
+}
+
+static int Visible(const mv_node_t* node, uint64_t snapshot) {
+  return node->ins_ts <= snapshot &&
+         snapshot < atomic_load_explicit(&node->del_ts, memory_order_relaxed);
+}
+
+/* Returns the first node with key >= key and sets *pred_p to the node
+ * before it; called with write_mutex held */
+static mv_node_t* Find(mvcc_list_t* list, int key, mv_node_t** pred_p) {
+  mv_node_t* pred = list->head;
+  mv_node_t* curr = atomic_load_explicit(&pred->next, memory_order_relaxed);
+
+  while (curr->key < key) {
+    pred = curr;
+    curr = atomic_load_explicit(&curr->next, memory_order_relaxed);
+  }
+  *pred_p = pred;
+  return curr;
+}
+
+/* The version of key that is not deleted, if any, from the first version
+ * of key on; called with write_mutex held */
+static mv_node_t* Live(mv_node_t* node, int key) {
+  for (; node->key == key;
+       node = atomic_load_explicit(&node->next, memory_order_relaxed)) {
+    if (atomic_load_explicit(&node->del_ts, memory_order_relaxed) == MV_LIVE) {
+      return node;
+    }
+  }
+  return NULL;
+}
+
+/* Returns the snapshot of the calling reader */
+static uint64_t Begin_read(mvcc_list_t* list, long rank) {
+  epoch_enter(&list->epoch, rank);
+  atomic_store(&list->snapshots[rank].ts, atomic_load(&list->clock));
+  return atomic_load(&list->clock);
+}
+
+static void End_read(mvcc_list_t* list, long rank) {
+  atomic_store_explicit(&list->snapshots[rank].ts, MV_IDLE,
+                        memory_order_release);
+  epoch_exit(&list->epoch, rank);
+}
+
+/* No snapshot in use or to come is older than the horizon */
+static uint64_t Horizon(mvcc_list_t* list) {
+  uint64_t horizon = atomic_load(&list->clock);
+
+  for (int r = 0; r < list->thread_count; r++) {
+    uint64_t ts = atomic_load(&list->snapshots[r].ts);
+    if (ts < horizon) horizon = ts;
+  }
+  return horizon;
+}
+
+/* Unlinks the dead versions among the next MVCC_GC_CHUNK nodes; returns 0
+ * once it has reached the end of the list */
+static int Collect_chunk(mvcc_list_t* list, long rank) {
+  uint64_t horizon = Horizon(list);
+  int more = 1;
+
+  epoch_enter(&list->epoch, rank);
+  pthread_mutex_lock(&list->write_mutex);
+  mv_node_t* pred = list->gc_pred;
+  for (int n = 0; n < MVCC_GC_CHUNK; n++) {
+    mv_node_t* curr = atomic_load_explicit(&pred->next, memory_order_relaxed);
+    mv_node_t* next = atomic_load_explicit(&curr->next, memory_order_relaxed);
+    if (next == NULL) { /* curr is the tail */
+      pred = list->head;
+      more = 0;
+      break;
+    }
+    if (atomic_load_explicit(&curr->del_ts, memory_order_relaxed) <=
+        horizon) {
+      atomic_store_explicit(&pred->next, next, memory_order_release);
+      epoch_retire(&list->epoch, rank, curr);
+    } else {
+      pred = curr;
+    }
+  }
+  list->gc_pred = pred;
+  pthread_mutex_unlock(&list->write_mutex);
+  epoch_exit(&list->epoch, rank);
+  return more;
+}
+
+static void* Collect(void* arg) {
+  mvcc_list_t* list = arg;
+  struct timespec pause = {0, MVCC_GC_PAUSE_NS};
+
+  while (!atomic_load_explicit(&list->stop, memory_order_relaxed)) {
+    if (!Collect_chunk(list, list->thread_count)) nanosleep(&pause, NULL);
+  }
+  return NULL;
+}
+
+static void* Mvcc_create(int thread_count) {
+  mvcc_list_t* list = malloc(sizeof(mvcc_list_t));
+
+  list->head = Node_new(INT_MIN, 0, Node_new(INT_MAX, 0, NULL));
+  pthread_mutex_init(&list->write_mutex, NULL);
+  atomic_init(&list->clock, 0);
+  list->thread_count = thread_count;
+  list->snapshots =
+      aligned_alloc(64, thread_count * sizeof(mv_snapshot_t));
+  for (int r = 0; r < thread_count; r++) {
+    atomic_init(&list->snapshots[r].ts, MV_IDLE);
+  }
+  epoch_init(&list->epoch, thread_count + 1, free);
+  atomic_init(&list->stop, 0);
+  list->gc_pred = list->head;
+  pthread_create(&list->collector, NULL, Collect, list);
+  return list;
+}
+
+static int Mvcc_insert(void* set, int value, long rank) {
+  mvcc_list_t* list = set;
+  mv_node_t* pred;
+  int inserted = 0;
+
+  pthread_mutex_lock(&list->write_mutex);
+  mv_node_t* first = Find(list, value, &pred);
+  if (Live(first, value) == NULL) {
+    uint64_t ts = atomic_load_explicit(&list->clock, memory_order_relaxed) + 1;
+    atomic_store_explicit(&pred->next, Node_new(value, ts, first),
+                          memory_order_release);
+    atomic_store(&list->clock, ts); /* Commit */
+    inserted = 1;
+  }
+  pthread_mutex_unlock(&list->write_mutex);
+  return inserted;
+}
+
+static int Mvcc_member(void* set, int value, long rank) {
+  mvcc_list_t* list = set;
+  uint64_t snapshot = Begin_read(list, rank);
+  mv_node_t* curr =
+      atomic_load_explicit(&list->head->next, memory_order_acquire);
+  int found = 0;
+
+  while (curr->key < value) {
+    curr = atomic_load_explicit(&curr->next, memory_order_acquire);
+  }
+  for (; curr->key == value && !found;
+       curr = atomic_load_explicit(&curr->next, memory_order_acquire)) {
+    found = Visible(curr, snapshot);
+  }
+  End_read(list, rank);
+  return found;
+}
+
+static int Mvcc_delete(void* set, int value, long rank) {
+  mvcc_list_t* list = set;
+  mv_node_t* pred;
+  int deleted = 0;
+
+  pthread_mutex_lock(&list->write_mutex);
+  mv_node_t* live = Live(Find(list, value, &pred), value);
+  if (live != NULL) {
+    uint64_t ts = atomic_load_explicit(&list->clock, memory_order_relaxed) + 1;
+    atomic_store_explicit(&live->del_ts, ts, memory_order_relaxed);
+    atomic_store(&list->clock, ts); /* Commit */
+    deleted = 1;
+  }
+  pthread_mutex_unlock(&list->write_mutex);
+  return deleted;
+}
+
+static int Mvcc_scan(void* set, int low, int high, long rank) {
+  mvcc_list_t* list = set;
+  uint64_t snapshot = Begin_read(list, rank);
+  mv_node_t* curr =
+      atomic_load_explicit(&list->head->next, memory_order_acquire);
+  int count = 0;
+
+  while (curr->key < low) {
+    curr = atomic_load_explicit(&curr->next, memory_order_acquire);
+  }
+  for (; curr->key < high;
+       curr = atomic_load_explicit(&curr->next, memory_order_acquire)) {
+    count += Visible(curr, snapshot);
+  }
+  End_read(list, rank);
+  return count;
+}
+
+static void Mvcc_destroy(void* set) {
+  mvcc_list_t* list = set;
+  mv_node_t* curr = list->head;
+
+  atomic_store(&list->stop, 1);
+  pthread_join(list->collector, NULL);
+  while (curr != NULL) {
+    mv_node_t* next = atomic_load(&curr->next);
+    free(curr);
+    curr = next;
+  }
+  epoch_destroy(&list->epoch);
+  free(list->snapshots);
+  pthread_mutex_destroy(&list->write_mutex);
+  free(list);
+}
+
+const set_backend_t mvcc_backend = {
+    "mvcc",      Mvcc_create,  Mvcc_insert, Mvcc_member,
+    Mvcc_delete, Mvcc_destroy, NULL,        Mvcc_scan};
@@ -0,0 +1,132 @@
+/* File:     rcu_list.c
+ *
+ * Purpose:  sorted linked list set backend for rw_lock.c with lock-free
+ *           readers (read-copy update)
+ *
+ * Notes:
+ * 1.  Member takes no lock and writes no shared memory: it follows the
+ *     next pointers with acquire loads.  Insert and Delete serialize on
+ *     one mutex and change the list with a single release store each, so
+ *     a reader sees either the old or the new list.
+ * 2.  A node's key never changes after it is published, so the
+ *     copy-on-write of RCU reduces to initializing a new node completely
+ *     before linking it in.
+ * 3.  Unlinked nodes are freed through quiescent-state-based reclamation
+ *     (qsbr.c).  Every operation ends in a quiescent state, so a reader
+ *     pays one store to its own cache line per operation.
+ */
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "qsbr.h"
+#include "set_backend.h"
+
+typedef struct rcu_node {
+  int key;
+  _Atomic(struct rcu_node*) next;
+} rcu_node_t;
+
+typedef struct {
+  rcu_node_t* head; /* Key INT_MIN */
+  pthread_mutex_t write_mutex;
+  qsbr_t qsbr;
+} rcu_list_t;
+
+static rcu_node_t* Node_new(int key, rcu_node_t* next) {
+  rcu_node_t* node = malloc(sizeof(rcu_node_t));
+  node->key = key;
+  atomic_init(&node->next, next);
+  return node;
+}
+
+/* Returns the first node with key >= key and sets *pred_p to the node
+ * before it; called with write_mutex held */
+static rcu_node_t* Find(rcu_list_t* list, int key, rcu_node_t** pred_p) {
+  rcu_node_t* pred = list->head;
+  rcu_node_t* curr = atomic_load_explicit(&pred->next, memory_order_relaxed);
+
+  while (curr->key < key) {
+    pred = curr;
+    curr = atomic_load_explicit(&curr->next, memory_order_relaxed);
+  }
+  *pred_p = pred;
+  return curr;
+}
+
+static void* Rcu_create(int thread_count) {
+  rcu_list_t* list = malloc(sizeof(rcu_list_t));
+
+  list->head = Node_new(INT_MIN, Node_new(INT_MAX, NULL));
+  pthread_mutex_init(&list->write_mutex, NULL);
+  qsbr_init(&list->qsbr, thread_count, free);
+  return list;
+}
+
+static int Rcu_insert(void* set, int value, long rank) {
+  rcu_list_t* list = set;
+  rcu_node_t* pred;
+  int inserted = 0;
+
+  pthread_mutex_lock(&list->write_mutex);
+  rcu_node_t* curr = Find(list, value, &pred);
+  if (curr->key != value) {
+    atomic_store_explicit(&pred->next, Node_new(value, curr),
+                          memory_order_release);
+    inserted = 1;
+  }
+  pthread_mutex_unlock(&list->write_mutex);
+  qsbr_quiescent(&list->qsbr, rank);
+  return inserted;
+}
+
+static int Rcu_member(void* set, int value, long rank) {
+  rcu_list_t* list = set;
+  rcu_node_t* curr =
+      atomic_load_explicit(&list->head->next, memory_order_acquire);
+
+  while (curr->key < value) {
+    curr = atomic_load_explicit(&curr->next, memory_order_acquire);
+  }
+  int found = curr->key == value;
+  qsbr_quiescent(&list->qsbr, rank);
+  return found;
+}
+
+static int Rcu_delete(void* set, int value, long rank) {
+  rcu_list_t* list = set;
+  rcu_node_t* pred;
+  int deleted = 0;
+
+  pthread_mutex_lock(&list->write_mutex);
+  rcu_node_t* curr = Find(list, value, &pred);
+  if (curr->key == value) {
+    /* Readers on curr still reach the rest of the list through it */
+    atomic_store_explicit(
+        &pred->next, atomic_load_explicit(&curr->next, memory_order_relaxed),
+        memory_order_release);
+    qsbr_retire(&list->qsbr, rank, curr);
+    deleted = 1;
+  }
+  pthread_mutex_unlock(&list->write_mutex);
+  qsbr_quiescent(&list->qsbr, rank);
+  return deleted;
+}
+
+static void Rcu_destroy(void* set) {
+  rcu_list_t* list = set;
+  rcu_node_t* curr = list->head;
+
+  while (curr != NULL) {
+    rcu_node_t* next = atomic_load(&curr->next);
+    free(curr);
+    curr = next;
+  }
+  qsbr_destroy(&list->qsbr);
+  pthread_mutex_destroy(&list->write_mutex);
+  free(list);
+}
+
+const set_backend_t rcu_backend = {"rcu",      Rcu_create, Rcu_insert,
+                                   Rcu_member, Rcu_delete, Rcu_destroy};
@@ -1,35 +1,72 @@
+#define _GNU_SOURCE /* pthread_rwlockattr_setkind_np */
+#include <limits.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "bravo_rwlock.h"
+#include "flat_combining.h"
+#ifdef INSTRUMENT
+#include "latency_hist.h"
+#endif
 #include "my_rand.h"
+#include "my_rwlock.h"
+#include "node_pool.h"
+#include "reduce.h"
+#include "set_backend.h"
 #include "timer.h"
+#include "unrolled_list.h"
+#include "workload.h"
+
+/* Reader-writer locks of the rwlock mode, selectable with -l */
+typedef enum { LOCK_MY, LOCK_BRAVO, LOCK_PTHREAD } rwl_kind_t;
+const char* const LOCK_NAMES[] = {"my", "bravo", "pthread"};
+const int LOCK_KIND_COUNT = sizeof(LOCK_NAMES) / sizeof(LOCK_NAMES[0]);
+
+/* Node allocators of the rwlock and fc modes, selectable with -a */
+typedef enum { ALLOC_MALLOC, ALLOC_POOL } alloc_kind_t;
+const char* const ALLOC_NAMES[] = {"malloc", "pool"};
+const int ALLOC_KIND_COUNT = sizeof(ALLOC_NAMES) / sizeof(ALLOC_NAMES[0]);
 
-/* Constants for priority modes */
-#define READ_PRIORITY 0
-#define WRITE_PRIORITY 1
+/* Structures of the list of the rwlock and fc modes, selectable with -s */
+typedef enum { STRUCT_LIST, STRUCT_UNROLLED } struct_kind_t;
+const char* const STRUCT_NAMES[] = {"list", "unrolled"};
+const int STRUCT_KIND_COUNT = sizeof(STRUCT_NAMES) / sizeof(STRUCT_NAMES[0]);
 
 /* Random ints are less than MAX_KEY */
 const int MAX_KEY = 100000000;
 
+/* Threads in a duration-based phase read the clock every CLOCK_INTERVAL
+ * ops */
+const int CLOCK_INTERVAL = 64;
+
+/* A Member of the seqlock mode takes the lock after SEQ_MAX_RETRIES
+ * failed optimistic attempts */
+const int SEQ_MAX_RETRIES = 16;
+
+/* main inserts the initial keys in batches of up to PRELOAD_BATCH */
+const int PRELOAD_BATCH = 65536;
+
+/* The keys inserted by main come from stream 0 of the random sequence
+ * starting at BASE_SEED, the ops of the threads from stream 1 */
+const unsigned BASE_SEED = 1;
+
 /* Struct for list nodes */
 struct list_node_s {
   int data;
   struct list_node_s* next;
 };
 
-/* Custom Read-Write Lock Structure */
+/* Member outcomes of one thread in the seqlock mode */
 typedef struct {
-  pthread_mutex_t mutex;       /* Mutex to protect the structure */
-  pthread_cond_t readers_cond; /* Condition variable for readers */
-  pthread_cond_t writers_cond; /* Condition variable for writers */
-  int active_readers;          /* Number of active readers */
-  int waiting_readers;         /* Number of readers waiting */
-  int active_writers;          /* Number of active writers (0 or 1) */
-  int waiting_writers;         /* Number of writers waiting */
-  int priority;                /* 0 for read-priority, 1 for write-priority */
-} my_rwlock_t;
+  long long reads;     /* Member calls */
+  long long retries;   /* Optimistic traversals thrown away */
+  long long fallbacks; /* Member calls that ended up taking the lock */
+} __attribute__((aligned(64))) seq_stats_t;
 
 /* Shared variables */
 struct list_node_s* head = NULL;
@@ -38,129 +75,260 @@ int total_ops;
 double insert_percent;
 double search_percent;
 double delete_percent;
-my_rwlock_t rwlock; /* Custom read-write lock */
+rwl_kind_t lock_kind = LOCK_MY; /* Lock of the rwlock mode (-l) */
+my_rwlock_t rwlock;             /* Custom read-write lock */
+bravo_rwlock_t bravo_rwlock;    /* Reader-biased distributed lock */
+pthread_rwlock_t pthread_rwlock;
+alloc_kind_t alloc_kind = ALLOC_MALLOC; /* Node allocator (-a) */
+node_pool_t node_pool;
+struct_kind_t struct_kind = STRUCT_LIST; /* Structure of the list (-s) */
+unrolled_list_t unrolled; /* Takes the place of head with -s unrolled */
+flat_combiner_t combiner; /* Serializes the list in the fc mode */
+pthread_mutex_t seq_mutex; /* Writers of the seqlock mode */
+/* Odd while a writer of the seqlock mode changes the list */
+_Atomic unsigned long seq_version __attribute__((aligned(64)));
+seq_stats_t* seq_stats; /* One per thread */
+#ifdef BASELINE_COMBINE
 pthread_mutex_t count_mutex;
-int member_count = 0, insert_count = 0, delete_count = 0;
+#else
+reducer_t count_reducer; /* Combines the op counts of the threads */
+#endif
+int member_count = 0, insert_count = 0, delete_count = 0, scan_count = 0;
+const set_backend_t* backend; /* Set implementation under test (-m) */
+void* set;                    /* Its instance */
+int use_workload = 0;         /* Run the phases of -w instead of the input */
+int batch_size = 1;           /* Ops the threads submit at once (-B) */
+workload_t workload;
+pthread_barrier_t phase_barrier; /* Threads start each phase together */
+double* phase_elapsed;           /* Wall time of each phase */
+long long (*phase_counts)[WL_OP_COUNT]; /* Ops of each phase by type */
+#ifdef INSTRUMENT
+/* Per thread and op type, in ns; the last one is for whole batches */
+lh_hist_t (*op_latency)[WL_OP_COUNT + 1];
+#endif
 
 /* Function declarations */
 void Usage(char* prog_name);
 void Get_input(int* inserts_in_main_p);
 void* Thread_work(void* rank);
-int Insert(int value);
+void* Workload_work(void* rank);
+void Run_op(wl_op_t op, int key, long my_rank);
+void Add_counts(const long long my_counts[], int p, long my_rank);
+void Tally(const long long counts[], int p);
+void Run_scan(int low, long long range, long my_rank);
+void Submit(set_op_t* batch, int* batched_p, wl_op_t op, int key,
+            long my_rank);
+void Flush(set_op_t* batch, int* batched_p, long my_rank);
+int Set_batch(set_op_t* ops, int count, long rank);
+void Print_phases(void);
+#ifdef INSTRUMENT
+void Print_latencies(void);
+#endif
+int Insert(int value, long rank);
 void Print(void);
 int Member(int value);
-int Delete(int value);
+int Delete(int value, long rank);
+int Scan(int low, int high);
+int Compare_ops(const void* a, const void* b);
+int Apply_batch(set_op_t* ops, int count, long rank);
+struct list_node_s* Node_alloc(long rank);
+void Node_free(struct list_node_s* node, long rank);
+void Set_node(struct list_node_s* node, int data, struct list_node_s* next);
+void Set_link(struct list_node_s* pred, struct list_node_s* node);
 void Free_list(void);
 int Is_empty(void);
 
-/* Custom Read-Write Lock Functions */
-
-/* Initialize the custom read-write lock */
-void my_rwlock_init(my_rwlock_t* lock, int priority_mode) {
-  pthread_mutex_init(&lock->mutex, NULL);
-  pthread_cond_init(&lock->readers_cond, NULL);
-  pthread_cond_init(&lock->writers_cond, NULL);
-  lock->active_readers = 0;
-  lock->waiting_readers = 0;
-  lock->active_writers = 0;
-  lock->waiting_writers = 0;
-  lock->priority = priority_mode;
-}
-
-/* Acquire the lock for reading */
-void my_rwlock_rdlock(my_rwlock_t* lock) {
-  pthread_mutex_lock(&lock->mutex);
-  if (lock->priority == READ_PRIORITY) {
-    /* Read-priority: Readers proceed if no active writers */
-    while (lock->active_writers > 0) {
-      lock->waiting_readers++;
-      pthread_cond_wait(&lock->readers_cond, &lock->mutex);
-      lock->waiting_readers--;
-    }
-  } else {
-    /* Write-priority: Readers wait if there are active or waiting writers */
-    while (lock->active_writers > 0 || lock->waiting_writers > 0) {
-      lock->waiting_readers++;
-      pthread_cond_wait(&lock->readers_cond, &lock->mutex);
-      lock->waiting_readers--;
-    }
-  }
-  lock->active_readers++;
-  pthread_mutex_unlock(&lock->mutex);
-}
+/* The lock selected with -l */
+void Lock_init(int priority_mode);
+void Lock_destroy(void);
+void Read_lock(long rank);
+void Read_unlock(long rank);
+void Write_lock(void);
+void Write_unlock(void);
 
-/* Acquire the lock for writing */
-void my_rwlock_wrlock(my_rwlock_t* lock) {
-  pthread_mutex_lock(&lock->mutex);
-  lock->waiting_writers++;
-  while (lock->active_writers > 0 || lock->active_readers > 0) {
-    pthread_cond_wait(&lock->writers_cond, &lock->mutex);
-  }
-  lock->waiting_writers--;
-  lock->active_writers++;
-  pthread_mutex_unlock(&lock->mutex);
-}
+/* The list above under the lock, as a set backend */
+void* Rwl_create(int thread_count);
+int Rwl_insert(void* set, int value, long rank);
+int Rwl_member(void* set, int value, long rank);
+int Rwl_delete(void* set, int value, long rank);
+void Rwl_destroy(void* set);
+int Rwl_batch(void* set, set_op_t* ops, int count, long rank);
+int Rwl_scan(void* set, int low, int high, long rank);
 
-/* Release the lock */
-void my_rwlock_unlock(my_rwlock_t* lock) {
-  pthread_mutex_lock(&lock->mutex);
-  if (lock->active_writers > 0) {
-    /* Unlocking a writer */
-    lock->active_writers--;
-  } else {
-    /* Unlocking a reader */
-    lock->active_readers--;
-  }
-
-  if (lock->active_writers == 0) {
-    if (lock->priority == WRITE_PRIORITY && lock->waiting_writers > 0) {
-      /* Give priority to writers */
-      pthread_cond_signal(&lock->writers_cond);
-    } else if (lock->waiting_readers > 0) {
-      /* Wake up all waiting readers */
-      pthread_cond_broadcast(&lock->readers_cond);
-    } else if (lock->waiting_writers > 0) {
-      /* Wake up one waiting writer */
-      pthread_cond_signal(&lock->writers_cond);
-    }
-  }
-  pthread_mutex_unlock(&lock->mutex);
-}
+const set_backend_t rwlock_backend = {
+    "rwlock",   Rwl_create,  Rwl_insert, Rwl_member,
+    Rwl_delete, Rwl_destroy, Rwl_batch,  Rwl_scan};
+
+/* The same list, with every op run by a flat combiner */
+void* Fc_create(int thread_count);
+void Fc_apply(void* context, set_op_t* ops, int count, long rank);
+int Fc_insert(void* set, int value, long rank);
+int Fc_member(void* set, int value, long rank);
+int Fc_delete(void* set, int value, long rank);
+void Fc_destroy(void* set);
+int Fc_batch(void* set, set_op_t* ops, int count, long rank);
+
+const set_backend_t fc_backend = {"fc",      Fc_create, Fc_insert,
+                                  Fc_member, Fc_delete, Fc_destroy,
+                                  Fc_batch};
+
+/* The same list, writers under a mutex, Member optimistic */
+void* Seq_create(int thread_count);
+void Seq_write_begin(void);
+void Seq_write_end(void);
+int Optimistic_member(int value);
+int Seq_insert(void* set, int value, long rank);
+int Seq_member(void* set, int value, long rank);
+int Seq_delete(void* set, int value, long rank);
+void Seq_destroy(void* set);
+int Seq_batch(void* set, set_op_t* ops, int count, long rank);
+void Print_seq_stats(void);
+
+const set_backend_t seqlock_backend = {
+    "seqlock",  Seq_create,  Seq_insert, Seq_member,
+    Seq_delete, Seq_destroy, Seq_batch};
+
+/* Set implementations selectable with -m, the default first */
+const set_backend_t* const BACKENDS[] = {
+    &rwlock_backend, &fc_backend,     &seqlock_backend, &skiplist_backend,
+    &hoh_backend,    &harris_backend, &rcu_backend,     &hash_backend,
+    &mvcc_backend};
+const int BACKEND_COUNT = sizeof(BACKENDS) / sizeof(BACKENDS[0]);
 
 /*-----------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
   long i;
-  int key, success, attempts;
+  int key, count, attempts;
+  set_op_t* preload;
   pthread_t* thread_handles;
   int inserts_in_main;
-  unsigned seed = 1;
+  unsigned seed = my_rand_stream(BASE_SEED, 0);
   double start, finish;
   int priority_mode;
+  int opt;
+  long long key_range = MAX_KEY;
 
-  if (argc != 3) Usage(argv[0]);
-  thread_count = strtol(argv[1], NULL, 10);
+  backend = BACKENDS[0];
+  while ((opt = getopt(argc, argv, "m:l:a:w:B:s:")) != -1) {
+    if (opt == 'B') {
+      batch_size = strtol(optarg, NULL, 10);
+      if (batch_size < 1) {
+        fprintf(stderr, "Invalid batch size '%s'.\n", optarg);
+        Usage(argv[0]);
+      }
+    } else if (opt == 'w') {
+      if (wl_load(&workload, optarg, MAX_KEY) != 0) Usage(argv[0]);
+      use_workload = 1;
+    } else if (opt == 's') {
+      struct_kind = STRUCT_KIND_COUNT;
+      for (int k = 0; k < STRUCT_KIND_COUNT; k++) {
+        if (strcmp(optarg, STRUCT_NAMES[k]) == 0) struct_kind = k;
+      }
+      if (struct_kind == STRUCT_KIND_COUNT) {
+        fprintf(stderr, "Invalid structure '%s'.\n", optarg);
+        Usage(argv[0]);
+      }
+    } else if (opt == 'a') {
+      alloc_kind = ALLOC_KIND_COUNT;
+      for (int k = 0; k < ALLOC_KIND_COUNT; k++) {
+        if (strcmp(optarg, ALLOC_NAMES[k]) == 0) alloc_kind = k;
+      }
+      if (alloc_kind == ALLOC_KIND_COUNT) {
+        fprintf(stderr, "Invalid allocator '%s'.\n", optarg);
+        Usage(argv[0]);
+      }
+    } else if (opt == 'l') {
+      lock_kind = LOCK_KIND_COUNT;
+      for (int k = 0; k < LOCK_KIND_COUNT; k++) {
+        if (strcmp(optarg, LOCK_NAMES[k]) == 0) lock_kind = k;
+      }
+      if (lock_kind == LOCK_KIND_COUNT) {
+        fprintf(stderr, "Invalid lock '%s'.\n", optarg);
+        Usage(argv[0]);
+      }
+    } else if (opt == 'm') {
+      backend = NULL;
+      for (int b = 0; b < BACKEND_COUNT; b++) {
+        if (strcmp(optarg, BACKENDS[b]->name) == 0) backend = BACKENDS[b];
+      }
+      if (backend == NULL) {
+        fprintf(stderr, "Invalid mode '%s'.\n", optarg);
+        Usage(argv[0]);
+      }
+    } else {
+      Usage(argv[0]);
+    }
+  }
+  if (argc - optind != 2) Usage(argv[0]);
+  thread_count = strtol(argv[optind], NULL, 10);
+  /* Optimistic readers may reach freed nodes, which must stay list nodes */
+  if (backend == &seqlock_backend) alloc_kind = ALLOC_POOL;
+  if (struct_kind == STRUCT_UNROLLED &&
+      ((backend != &rwlock_backend && backend != &fc_backend) ||
+       alloc_kind == ALLOC_POOL)) {
+    fprintf(stderr, "-s unrolled needs the rwlock or fc mode and malloc.\n");
+    Usage(argv[0]);
+  }
+  for (int p = 0; use_workload && p < workload.phase_count; p++) {
+    if (workload.phases[p].scan > 0.0 && backend->scan == NULL) {
+      fprintf(stderr, "Mode %s has no scan op.\n", backend->name);
+      Usage(argv[0]);
+    }
+  }
 
   /* Parse priority mode */
-  if (strcmp(argv[2], "read") == 0) {
+  if (strcmp(argv[optind + 1], "read") == 0) {
     priority_mode = READ_PRIORITY;
-  } else if (strcmp(argv[2], "write") == 0) {
+  } else if (strcmp(argv[optind + 1], "write") == 0) {
     priority_mode = WRITE_PRIORITY;
   } else {
     fprintf(stderr, "Invalid priority_mode. Use 'read' or 'write'.\n");
     Usage(argv[0]);
   }
 
-  Get_input(&inserts_in_main);
+  if (use_workload) {
+    inserts_in_main = workload.init;
+    key_range = workload.keys;
+    wl_print(&workload);
+  } else {
+    Get_input(&inserts_in_main);
+  }
+
+  /* Initialize the read-write lock */
+  Lock_init(priority_mode);
+  if (struct_kind == STRUCT_UNROLLED && ul_init(&unrolled) != 0) {
+    fprintf(stderr, "Cannot allocate the unrolled list.\n");
+    exit(1);
+  }
+  if ((backend == &rwlock_backend || backend == &fc_backend ||
+       backend == &seqlock_backend) &&
+      alloc_kind == ALLOC_POOL &&
+      np_init(&node_pool, sizeof(struct list_node_s), thread_count) != 0) {
+    fprintf(stderr, "Cannot allocate the node pool.\n");
+    exit(1);
+  }
+  set = backend->create(thread_count);
 
   /* Try to insert inserts_in_main keys, but give up after */
-  /* 2*inserts_in_main attempts.                           */
+  /* 2*inserts_in_main attempts.  The keys go in as batches */
+  /* of the keys still missing, so a backend with a batch   */
+  /* op builds the list in one merged pass per batch.       */
+  preload = malloc(PRELOAD_BATCH * sizeof(set_op_t));
   i = attempts = 0;
   while (i < inserts_in_main && attempts < 2 * inserts_in_main) {
-    key = my_rand(&seed) % MAX_KEY;
-    success = Insert(key);
-    attempts++;
-    if (success) i++;
+    count = inserts_in_main - i;
+    if (count > 2 * inserts_in_main - attempts) {
+      count = 2 * inserts_in_main - attempts;
+    }
+    if (count > PRELOAD_BATCH) count = PRELOAD_BATCH;
+    for (int b = 0; b < count; b++) {
+      key = my_rand(&seed) % key_range;
+      preload[b] = (set_op_t){key, WL_INSERT, 0, 0};
+    }
+    i += Set_batch(preload, count, 0);
+    attempts += count;
   }
+  free(preload);
   printf("Inserted %ld keys in empty list\n", i);
 
 #ifdef OUTPUT
@@ -170,22 +338,61 @@ int main(int argc, char* argv[]) {
 #endif
 
   thread_handles = malloc(thread_count * sizeof(pthread_t));
+#ifdef BASELINE_COMBINE
   pthread_mutex_init(&count_mutex, NULL);
+#else
+  if (reducer_init(&count_reducer, thread_count, &REDUCE_SUM, 0) != 0) {
+    fprintf(stderr, "Cannot allocate the reducer.\n");
+    exit(1);
+  }
+#endif
+  if (use_workload) {
+    pthread_barrier_init(&phase_barrier, NULL, thread_count);
+    phase_elapsed = calloc(workload.phase_count, sizeof(double));
+    phase_counts = calloc(workload.phase_count, sizeof(*phase_counts));
+  }
 
-  /* Initialize custom read-write lock */
-  my_rwlock_init(&rwlock, priority_mode);
+#ifdef INSTRUMENT
+  /* All zeros is an empty histogram */
+  op_latency = calloc(thread_count, sizeof(*op_latency));
+#endif
 
   GET_TIME(start);
   for (i = 0; i < thread_count; i++)
-    pthread_create(&thread_handles[i], NULL, Thread_work, (void*)i);
+    pthread_create(&thread_handles[i], NULL,
+                   use_workload ? Workload_work : Thread_work, (void*)i);
 
   for (i = 0; i < thread_count; i++) pthread_join(thread_handles[i], NULL);
   GET_TIME(finish);
+  if (use_workload) {
+    Print_phases();
+    total_ops = member_count + insert_count + delete_count + scan_count;
+  }
+  printf("Mode = %s\n", backend->name);
+  if (batch_size > 1) printf("Batch size = %d\n", batch_size);
+  if (struct_kind != STRUCT_LIST) {
+    printf("Structure = %s\n", STRUCT_NAMES[struct_kind]);
+  }
+  if (backend == &rwlock_backend) {
+    printf("Lock = %s, allocator = %s\n", LOCK_NAMES[lock_kind],
+           ALLOC_NAMES[alloc_kind]);
+  } else if (backend == &fc_backend) {
+    printf("Allocator = %s\n", ALLOC_NAMES[alloc_kind]);
+    printf("Combining passes = %llu, ops per pass = %.2f\n", combiner.passes,
+           combiner.passes ? (double)combiner.combined / combiner.passes : 0.0);
+  } else if (backend == &seqlock_backend) {
+    Print_seq_stats();
+  }
   printf("Elapsed time = %e seconds\n", finish - start);
   printf("Total ops = %d\n", total_ops);
   printf("member ops = %d\n", member_count);
   printf("insert ops = %d\n", insert_count);
   printf("delete ops = %d\n", delete_count);
+  if (scan_count > 0) printf("scan ops = %d\n", scan_count);
+#ifdef INSTRUMENT
+  Print_latencies();
+  free(op_latency);
+#endif
 
 #ifdef OUTPUT
   printf("After threads terminate, list = \n");
@@ -193,25 +400,63 @@ int main(int argc, char* argv[]) {
   printf("\n");
 #endif
 
-  Free_list();
+  backend->destroy(set);
 
-  /* Destroy custom read-write lock */
-  pthread_mutex_destroy(&rwlock.mutex);
-  pthread_cond_destroy(&rwlock.readers_cond);
-  pthread_cond_destroy(&rwlock.writers_cond);
+  /* Destroy the read-write lock */
+  Lock_destroy();
 
+#ifdef BASELINE_COMBINE
   pthread_mutex_destroy(&count_mutex);
+#else
+  reducer_destroy(&count_reducer);
+#endif
   free(thread_handles);
+  if (use_workload) {
+    pthread_barrier_destroy(&phase_barrier);
+    free(phase_elapsed);
+    free(phase_counts);
+    wl_free(&workload);
+  }
 
   return 0;
 }
 
 /*-----------------------------------------------------------------*/
 void Usage(char* prog_name) {
-  fprintf(stderr, "usage: %s <thread_count> <priority_mode>\n", prog_name);
+  fprintf(stderr,
+          "usage: %s <thread_count> <priority_mode> [-m mode] [-l lock] "
+          "[-a allocator] [-s structure] [-w workload] [-B batch_size]\n",
+          prog_name);
   fprintf(
       stderr,
       "priority_mode: 'read' for read-priority, 'write' for write-priority\n");
+  fprintf(stderr, "mode: set implementation,");
+  for (int b = 0; b < BACKEND_COUNT; b++) {
+    fprintf(stderr, " '%s'%s", BACKENDS[b]->name, b == 0 ? " (default)" : "");
+  }
+  fprintf(stderr, "\nlock: reader-writer lock of the rwlock mode,");
+  for (int k = 0; k < LOCK_KIND_COUNT; k++) {
+    fprintf(stderr, " '%s'%s", LOCK_NAMES[k], k == 0 ? " (default)" : "");
+  }
+  fprintf(stderr,
+          "\nallocator: list nodes of the rwlock and fc modes (seqlock "
+          "always uses 'pool'),");
+  for (int k = 0; k < ALLOC_KIND_COUNT; k++) {
+    fprintf(stderr, " '%s'%s", ALLOC_NAMES[k], k == 0 ? " (default)" : "");
+  }
+  fprintf(stderr, "\nstructure: list of the rwlock and fc modes,");
+  for (int k = 0; k < STRUCT_KIND_COUNT; k++) {
+    fprintf(stderr, " '%s'%s", STRUCT_NAMES[k], k == 0 ? " (default)" : "");
+  }
+  fprintf(stderr,
+          "\nworkload: phase spec, or a file holding one, instead of the "
+          "input;\n  e.g. 'init=1000 keys=100000; member=0.9 insert=0.05 "
+          "dist=zipf:0.99 time=2';\n  scan=0.1 range=100 adds range "
+          "scans, which need a mode with a scan op\n");
+  fprintf(stderr,
+          "batch_size: ops each thread submits at once (default 1); the "
+          "rwlock mode\n  sorts a batch and runs it in one pass under one "
+          "lock acquisition\n");
   exit(0);
 }
 
@@ -231,25 +476,22 @@ void Get_input(int* inserts_in_main_p) {
 /*-----------------------------------------------------------------*/
 /* Insert value in correct numerical location into list */
 /* If value is not in list, return 1, else return 0 */
-int Insert(int value) {
+int Insert(int value, long rank) {
   struct list_node_s* curr = head;
   struct list_node_s* pred = NULL;
   struct list_node_s* temp;
   int rv = 1;
 
+  if (struct_kind == STRUCT_UNROLLED) return ul_insert(&unrolled, value);
   while (curr != NULL && curr->data < value) {
     pred = curr;
     curr = curr->next;
   }
 
   if (curr == NULL || curr->data > value) {
-    temp = malloc(sizeof(struct list_node_s));
-    temp->data = value;
-    temp->next = curr;
-    if (pred == NULL)
-      head = temp;
-    else
-      pred->next = temp;
+    temp = Node_alloc(rank);
+    Set_node(temp, value, curr);
+    Set_link(pred, temp);
   } else { /* value in list */
     rv = 0;
   }
@@ -262,6 +504,7 @@ void Print(void) {
   struct list_node_s* temp;
 
   printf("list = ");
+  if (struct_kind == STRUCT_UNROLLED) ul_print(&unrolled, stdout);
 
   temp = head;
   while (temp != (struct list_node_s*)NULL) {
@@ -275,6 +518,7 @@ void Print(void) {
 int Member(int value) {
   struct list_node_s* temp;
 
+  if (struct_kind == STRUCT_UNROLLED) return ul_member(&unrolled, value);
   temp = head;
   while (temp != NULL && temp->data < value) temp = temp->next;
 
@@ -294,11 +538,12 @@ int Member(int value) {
 /*-----------------------------------------------------------------*/
 /* Deletes value from list */
 /* If value is in list, return 1, else return 0 */
-int Delete(int value) {
+int Delete(int value, long rank) {
   struct list_node_s* curr = head;
   struct list_node_s* pred = NULL;
   int rv = 1;
 
+  if (struct_kind == STRUCT_UNROLLED) return ul_delete(&unrolled, value);
   /* Find value */
   while (curr != NULL && curr->data < value) {
     pred = curr;
@@ -306,19 +551,11 @@ int Delete(int value) {
   }
 
   if (curr != NULL && curr->data == value) {
-    if (pred == NULL) { /* first element in list */
-      head = curr->next;
+    Set_link(pred, curr->next); /* head if curr is the first element */
 #ifdef DEBUG
-      printf("Freeing %d\n", value);
+    printf("Freeing %d\n", value);
 #endif
-      free(curr);
-    } else {
-      pred->next = curr->next;
-#ifdef DEBUG
-      printf("Freeing %d\n", value);
-#endif
-      free(curr);
-    }
+    Node_free(curr, rank);
   } else { /* Not in list */
     rv = 0;
   }
@@ -326,11 +563,90 @@ int Delete(int value) {
   return rv;
 }
 
+/*-----------------------------------------------------------------*/
+/* Returns how many keys of the list are in [low, high) */
+int Scan(int low, int high) {
+  struct list_node_s* temp = head;
+  int count = 0;
+
+  if (struct_kind == STRUCT_UNROLLED) return ul_scan(&unrolled, low, high);
+  while (temp != NULL && temp->data < low) temp = temp->next;
+  for (; temp != NULL && temp->data < high; temp = temp->next) count++;
+  return count;
+}
+
+/*-----------------------------------------------------------------*/
+/* Orders batch ops by key, then by their position in the batch */
+int Compare_ops(const void* a, const void* b) {
+  const set_op_t* x = a;
+  const set_op_t* y = b;
+
+  if (x->key != y->key) return x->key < y->key ? -1 : 1;
+  return x->index - y->index;
+}
+
+/*-----------------------------------------------------------------*/
+/* Applies ops, sorted by key, in a single traversal of the list: pred and
+ * curr only move forward.  Returns how many ops returned 1 */
+int Apply_batch(set_op_t* ops, int count, long rank) {
+  struct list_node_s* curr = head;
+  struct list_node_s* pred = NULL;
+  struct list_node_s* temp;
+  int successes = 0;
+
+  if (struct_kind == STRUCT_UNROLLED) {
+    return ul_apply_batch(&unrolled, ops, count);
+  }
+  for (int b = 0; b < count; b++) {
+    int value = ops[b].key;
+    while (curr != NULL && curr->data < value) {
+      pred = curr;
+      curr = curr->next;
+    }
+    int present = curr != NULL && curr->data == value;
+
+    switch (ops[b].op) {
+      case WL_MEMBER:
+        ops[b].result = present;
+        break;
+      case WL_INSERT:
+        ops[b].result = !present;
+        if (!present) {
+          temp = Node_alloc(rank);
+          Set_node(temp, value, curr);
+          Set_link(pred, temp);
+          curr = temp; /* Later ops on value see it */
+        }
+        break;
+      default: /* WL_DELETE */
+        ops[b].result = present;
+        if (present) {
+          temp = curr;
+          curr = curr->next;
+          Set_link(pred, curr);
+          Node_free(temp, rank);
+        }
+        break;
+    }
+    successes += ops[b].result;
+  }
+  return successes;
+}
+
 /*-----------------------------------------------------------------*/
 void Free_list(void) {
   struct list_node_s* current;
   struct list_node_s* following;
 
+  if (struct_kind == STRUCT_UNROLLED) {
+    ul_destroy(&unrolled);
+    return;
+  }
+  if (alloc_kind == ALLOC_POOL) { /* Release all arenas at once */
+    np_destroy(&node_pool);
+    head = NULL;
+    return;
+  }
   if (Is_empty()) return;
   current = head;
   following = current->next;
@@ -348,6 +664,53 @@ void Free_list(void) {
   free(current);
 }
 
+/*-----------------------------------------------------------------*/
+/* Nodes come from malloc or from the caller's part of the node pool.
+ * Running out of memory ends the program, as in main */
+struct list_node_s* Node_alloc(long rank) {
+  struct list_node_s* node;
+
+  if (alloc_kind == ALLOC_POOL) {
+    node = np_alloc(&node_pool, rank);
+  } else {
+    node = malloc(sizeof(struct list_node_s));
+  }
+  if (node == NULL) {
+    fprintf(stderr, "Cannot allocate a list node.\n");
+    exit(1);
+  }
+  return node;
+}
+
+void Node_free(struct list_node_s* node, long rank) {
+  if (alloc_kind == ALLOC_POOL) {
+    np_free(&node_pool, rank, node);
+  } else {
+    free(node);
+  }
+}
+
+/*-----------------------------------------------------------------*/
+/* Every store of Insert, Delete and Apply_batch to the list goes through
+ * these.  The optimistic readers of the seqlock mode load the same fields
+ * at the same time, so the stores are atomic.  A node's fields are
+ * relaxed, since the readers validate against seq_version; the link that
+ * publishes a node is a release store, so a reader that follows it with
+ * an acquire load sees the node initialized */
+void Set_node(struct list_node_s* node, int data, struct list_node_s* next) {
+  __atomic_store_n(&node->data, data, __ATOMIC_RELAXED);
+  __atomic_store_n(&node->next, next, __ATOMIC_RELAXED);
+}
+
+/* Makes node follow pred, or the head of the list if pred is NULL */
+void Set_link(struct list_node_s* pred, struct list_node_s* node) {
+  if (pred == NULL) {
+    __atomic_store_n(&head, node, __ATOMIC_RELEASE);
+  } else {
+    __atomic_store_n(&pred->next, node, __ATOMIC_RELEASE);
+  }
+}
+
 /*-----------------------------------------------------------------*/
 int Is_empty(void) {
   if (head == NULL)
@@ -356,41 +719,583 @@ int Is_empty(void) {
     return 0;
 }
 
+/*-----------------------------------------------------------------*/
+/* Both priority modes map onto pthread_rwlock_t through the glibc kinds;
+ * the non-recursive writer kind is the one that makes readers wait for
+ * waiting writers */
+void Lock_init(int priority_mode) {
+  pthread_rwlockattr_t attr;
+
+  switch (lock_kind) {
+    case LOCK_MY:
+      my_rwlock_init(&rwlock, priority_mode);
+      break;
+    case LOCK_BRAVO:
+      if (bravo_rwlock_init(&bravo_rwlock, priority_mode, thread_count) != 0) {
+        fprintf(stderr, "Cannot allocate the bravo lock.\n");
+        exit(1);
+      }
+      break;
+    case LOCK_PTHREAD:
+      pthread_rwlockattr_init(&attr);
+      pthread_rwlockattr_setkind_np(
+          &attr, priority_mode == WRITE_PRIORITY
+                     ? PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP
+                     : PTHREAD_RWLOCK_PREFER_READER_NP);
+      pthread_rwlock_init(&pthread_rwlock, &attr);
+      pthread_rwlockattr_destroy(&attr);
+      break;
+  }
+}
+
+void Lock_destroy(void) {
+  switch (lock_kind) {
+    case LOCK_MY:
+      my_rwlock_destroy(&rwlock);
+      break;
+    case LOCK_BRAVO:
+      bravo_rwlock_destroy(&bravo_rwlock);
+      break;
+    case LOCK_PTHREAD:
+      pthread_rwlock_destroy(&pthread_rwlock);
+      break;
+  }
+}
+
+void Read_lock(long rank) {
+  switch (lock_kind) {
+    case LOCK_MY:
+      my_rwlock_rdlock(&rwlock);
+      break;
+    case LOCK_BRAVO:
+      bravo_rdlock(&bravo_rwlock, rank);
+      break;
+    case LOCK_PTHREAD:
+      pthread_rwlock_rdlock(&pthread_rwlock);
+      break;
+  }
+}
+
+void Read_unlock(long rank) {
+  switch (lock_kind) {
+    case LOCK_MY:
+      my_rwlock_unlock(&rwlock);
+      break;
+    case LOCK_BRAVO:
+      bravo_rdunlock(&bravo_rwlock, rank);
+      break;
+    case LOCK_PTHREAD:
+      pthread_rwlock_unlock(&pthread_rwlock);
+      break;
+  }
+}
+
+void Write_lock(void) {
+  switch (lock_kind) {
+    case LOCK_MY:
+      my_rwlock_wrlock(&rwlock);
+      break;
+    case LOCK_BRAVO:
+      bravo_wrlock(&bravo_rwlock);
+      break;
+    case LOCK_PTHREAD:
+      pthread_rwlock_wrlock(&pthread_rwlock);
+      break;
+  }
+}
+
+void Write_unlock(void) {
+  switch (lock_kind) {
+    case LOCK_MY:
+      my_rwlock_unlock(&rwlock);
+      break;
+    case LOCK_BRAVO:
+      bravo_wrunlock(&bravo_rwlock);
+      break;
+    case LOCK_PTHREAD:
+      pthread_rwlock_unlock(&pthread_rwlock);
+      break;
+  }
+}
+
+/*-----------------------------------------------------------------*/
+/* The rwlock backend: the global list, one op at a time under the lock */
+void* Rwl_create(int thread_count) { return NULL; }
+
+int Rwl_insert(void* set, int value, long rank) {
+  Write_lock();
+  int rv = Insert(value, rank);
+  Write_unlock();
+  return rv;
+}
+
+int Rwl_member(void* set, int value, long rank) {
+  Read_lock(rank);
+  int rv = Member(value);
+  Read_unlock(rank);
+  return rv;
+}
+
+int Rwl_delete(void* set, int value, long rank) {
+  Write_lock();
+  int rv = Delete(value, rank);
+  Write_unlock();
+  return rv;
+}
+
+void Rwl_destroy(void* set) { Free_list(); }
+
+/* Sorts outside the lock, then applies the whole batch in one pass under
+ * one acquisition, as a reader if it only has Member ops */
+int Rwl_batch(void* set, set_op_t* ops, int count, long rank) {
+  int writes = 0;
+
+  for (int b = 0; b < count; b++) {
+    ops[b].index = b;
+    if (ops[b].op != WL_MEMBER) writes = 1;
+  }
+  qsort(ops, count, sizeof(set_op_t), Compare_ops);
+
+  if (writes) {
+    Write_lock();
+  } else {
+    Read_lock(rank);
+  }
+  int rv = Apply_batch(ops, count, rank);
+  if (writes) {
+    Write_unlock();
+  } else {
+    Read_unlock(rank);
+  }
+  return rv;
+}
+
+/* Holds the lock as a reader for the whole range, so writers wait */
+int Rwl_scan(void* set, int low, int high, long rank) {
+  Read_lock(rank);
+  int rv = Scan(low, high);
+  Read_unlock(rank);
+  return rv;
+}
+
+/*-----------------------------------------------------------------*/
+/* The fc backend: the global list, no lock; whichever thread holds the
+ * combiner flag runs everyone's pending ops in one sorted pass */
+void* Fc_create(int thread_count) {
+  if (fc_init(&combiner, thread_count, Fc_apply, NULL) != 0) {
+    fprintf(stderr, "Cannot allocate the flat combiner.\n");
+    exit(1);
+  }
+  return &combiner;
+}
+
+/* Runs with the combiner flag held; keeps the ops' index */
+void Fc_apply(void* context, set_op_t* ops, int count, long rank) {
+  qsort(ops, count, sizeof(set_op_t), Compare_ops);
+  Apply_batch(ops, count, rank);
+}
+
+int Fc_insert(void* set, int value, long rank) {
+  return fc_execute(set, rank, WL_INSERT, value);
+}
+
+int Fc_member(void* set, int value, long rank) {
+  return fc_execute(set, rank, WL_MEMBER, value);
+}
+
+int Fc_delete(void* set, int value, long rank) {
+  return fc_execute(set, rank, WL_DELETE, value);
+}
+
+void Fc_destroy(void* set) {
+  Free_list();
+  fc_destroy(set);
+}
+
+int Fc_batch(void* set, set_op_t* ops, int count, long rank) {
+  return fc_execute_batch(set, rank, ops, count);
+}
+
+/*-----------------------------------------------------------------*/
+/* The seqlock backend: the global list, writers serialized by seq_mutex
+ * and making seq_version odd while they change it.  Member traverses
+ * without a lock and retries if the version moved. */
+void* Seq_create(int thread_count) {
+  pthread_mutex_init(&seq_mutex, NULL);
+  atomic_init(&seq_version, 0);
+  seq_stats = aligned_alloc(64, thread_count * sizeof(seq_stats_t));
+  if (seq_stats == NULL) {
+    fprintf(stderr, "Cannot allocate the seqlock statistics.\n");
+    exit(1);
+  }
+  memset(seq_stats, 0, thread_count * sizeof(seq_stats_t));
+  return NULL;
+}
+
+void Seq_write_begin(void) {
+  pthread_mutex_lock(&seq_mutex);
+  atomic_store_explicit(&seq_version, atomic_load(&seq_version) + 1,
+                        memory_order_relaxed);
+  /* The odd version is visible before any change to the list */
+  atomic_thread_fence(memory_order_release);
+}
+
+void Seq_write_end(void) {
+  atomic_store_explicit(&seq_version, atomic_load(&seq_version) + 1,
+                        memory_order_release);
+  pthread_mutex_unlock(&seq_mutex);
+}
+
+/* Member without a lock.  Freed nodes stay in the node pool, and np_free
+ * only overwrites their data, so next always leads to a list node or
+ * NULL; the keys must increase along the way, which bounds a traversal
+ * of a list that is changing underneath.  Returns -1 if the keys did not
+ * increase, else what Member would have returned, to be validated
+ * against seq_version. */
+int Optimistic_member(int value) {
+  struct list_node_s* curr = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+  long last = LONG_MIN;
+
+  while (curr != NULL) {
+    int data = __atomic_load_n(&curr->data, __ATOMIC_RELAXED);
+    if (data <= last) return -1;
+    if (data >= value) return data == value;
+    last = data;
+    curr = __atomic_load_n(&curr->next, __ATOMIC_ACQUIRE);
+  }
+  return 0;
+}
+
+int Seq_insert(void* set, int value, long rank) {
+  Seq_write_begin();
+  int rv = Insert(value, rank);
+  Seq_write_end();
+  return rv;
+}
+
+int Seq_member(void* set, int value, long rank) {
+  seq_stats_t* stats = &seq_stats[rank];
+  int rv;
+
+  stats->reads++;
+  for (int attempt = 0; attempt < SEQ_MAX_RETRIES; attempt++) {
+    unsigned long version =
+        atomic_load_explicit(&seq_version, memory_order_acquire);
+    if (version % 2 == 0) {
+      rv = Optimistic_member(value);
+      /* The traversal's loads complete before the version is checked */
+      atomic_thread_fence(memory_order_acquire);
+      if (rv >= 0 && atomic_load_explicit(&seq_version,
+                                          memory_order_relaxed) == version) {
+        return rv;
+      }
+    } else {
+      sched_yield(); /* Let the writer finish */
+    }
+    stats->retries++;
+  }
+
+  stats->fallbacks++;
+  pthread_mutex_lock(&seq_mutex);
+  rv = Member(value);
+  pthread_mutex_unlock(&seq_mutex);
+  return rv;
+}
+
+int Seq_delete(void* set, int value, long rank) {
+  Seq_write_begin();
+  int rv = Delete(value, rank);
+  Seq_write_end();
+  return rv;
+}
+
+void Seq_destroy(void* set) {
+  Free_list();
+  pthread_mutex_destroy(&seq_mutex);
+  free(seq_stats);
+}
+
+/* Sorts outside the lock, then applies the whole batch in one pass as a
+ * single writer */
+int Seq_batch(void* set, set_op_t* ops, int count, long rank) {
+  for (int b = 0; b < count; b++) ops[b].index = b;
+  qsort(ops, count, sizeof(set_op_t), Compare_ops);
+
+  Seq_write_begin();
+  int rv = Apply_batch(ops, count, rank);
+  Seq_write_end();
+  return rv;
+}
+
+void Print_seq_stats(void) {
+  long long reads = 0, retries = 0, fallbacks = 0;
+
+  for (int r = 0; r < thread_count; r++) {
+    reads += seq_stats[r].reads;
+    retries += seq_stats[r].retries;
+    fallbacks += seq_stats[r].fallbacks;
+  }
+  printf("Allocator = %s\n", ALLOC_NAMES[alloc_kind]);
+  printf("Member retries = %lld (%.4f per Member), locked fallbacks = %lld\n",
+         retries, reads ? (double)retries / reads : 0.0, fallbacks);
+}
+
 /*-----------------------------------------------------------------*/
 void* Thread_work(void* rank) {
   long my_rank = (long)rank;
   int i, val;
   double which_op;
-  unsigned seed = my_rank + 1;
-  int my_member_count = 0, my_insert_count = 0, my_delete_count = 0;
+  unsigned seed;
+  long long my_counts[WL_OP_COUNT] = {0};
   int ops_per_thread = total_ops / thread_count;
+  int remainder = total_ops % thread_count;
+  long long my_first_op;
+  set_op_t* batch = malloc(batch_size * sizeof(set_op_t));
+  int batched = 0;
+
+  /* Each thread runs a contiguous block of the serial op sequence and
+   * jumps to its start: every op draws two numbers, so the ops are the
+   * same for any thread count */
+  if (my_rank < remainder) {
+    ops_per_thread++;
+    my_first_op = my_rank * ops_per_thread;
+  } else {
+    my_first_op = my_rank * ops_per_thread + remainder;
+  }
+  seed = my_rand_jump(my_rand_stream(BASE_SEED, 1), 2 * my_first_op);
 
   for (i = 0; i < ops_per_thread; i++) {
     which_op = my_drand(&seed);
     val = my_rand(&seed) % MAX_KEY;
     if (which_op < search_percent) {
-      my_rwlock_rdlock(&rwlock);
-      Member(val);
-      my_rwlock_unlock(&rwlock);
-      my_member_count++;
+      Submit(batch, &batched, WL_MEMBER, val, my_rank);
+      my_counts[WL_MEMBER]++;
     } else if (which_op < search_percent + insert_percent) {
-      my_rwlock_wrlock(&rwlock);
-      Insert(val);
-      my_rwlock_unlock(&rwlock);
-      my_insert_count++;
+      Submit(batch, &batched, WL_INSERT, val, my_rank);
+      my_counts[WL_INSERT]++;
     } else { /* delete */
-      my_rwlock_wrlock(&rwlock);
-      Delete(val);
-      my_rwlock_unlock(&rwlock);
-      my_delete_count++;
+      Submit(batch, &batched, WL_DELETE, val, my_rank);
+      my_counts[WL_DELETE]++;
+    }
+  }
+  Flush(batch, &batched, my_rank);
+  free(batch);
+
+  Add_counts(my_counts, -1, my_rank);
+
+  return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+/* Runs the phases of the workload.  The threads start every phase
+ * together after a barrier, and rank 0 times it up to the barrier that
+ * ends it */
+void* Workload_work(void* rank) {
+  long my_rank = (long)rank;
+  wl_gen_t gen;
+  int key;
+  double start, now;
+  set_op_t* batch = malloc(batch_size * sizeof(set_op_t));
+  int batched = 0;
+
+  wl_gen_init(&gen, my_rand_stream(BASE_SEED, 2 + my_rank), my_rank,
+              thread_count);
+  for (int p = 0; p < workload.phase_count; p++) {
+    const wl_phase_t* phase = &workload.phases[p];
+    long long my_ops = phase->ops / thread_count +
+                       (my_rank < phase->ops % thread_count ? 1 : 0);
+    long long my_counts[WL_OP_COUNT] = {0};
+
+    pthread_barrier_wait(&phase_barrier);
+    GET_TIME(start);
+    for (long long done = 0;; done++) {
+      if (phase->ops > 0) {
+        if (done == my_ops) break;
+      } else if (done % CLOCK_INTERVAL == 0) {
+        GET_TIME(now);
+        if (now - start >= phase->seconds) break;
+      }
+      wl_op_t op = wl_next(&workload, p, &gen, &key);
+      if (op == WL_SCAN) { /* Never batched; ops before it go first */
+        Flush(batch, &batched, my_rank);
+        Run_scan(key, phase->range, my_rank);
+      } else {
+        Submit(batch, &batched, op, key, my_rank);
+      }
+      my_counts[op]++;
+    }
+    Flush(batch, &batched, my_rank);
+
+    Add_counts(my_counts, p, my_rank);
+
+    pthread_barrier_wait(&phase_barrier);
+    if (my_rank == 0) {
+      GET_TIME(now);
+      phase_elapsed[p] = now - start;
     }
   }
 
+  free(batch);
+  return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+/* Adds the op counts of a thread to the totals, and to the counts of
+ * phase p unless p is -1.  Every thread must call it: the counts are
+ * combined with a reducer_t tree (reduce.c), or under count_mutex when
+ * built with BASELINE_COMBINE */
+void Add_counts(const long long my_counts[], int p, long my_rank) {
+#ifdef BASELINE_COMBINE
   pthread_mutex_lock(&count_mutex);
-  member_count += my_member_count;
-  insert_count += my_insert_count;
-  delete_count += my_delete_count;
+  Tally(my_counts, p);
   pthread_mutex_unlock(&count_mutex);
+#else
+  long long counts[WL_OP_COUNT];
 
-  return NULL;
-}
\ No newline at end of file
+  for (int op = 0; op < WL_OP_COUNT; op++) {
+    counts[op] = (long long)reducer_combine(&count_reducer, my_rank,
+                                            (double)my_counts[op]);
+  }
+  if (my_rank == 0) Tally(counts, p);
+#endif
+}
+
+/*-----------------------------------------------------------------*/
+void Tally(const long long counts[], int p) {
+  if (p >= 0) {
+    for (int op = 0; op < WL_OP_COUNT; op++) phase_counts[p][op] += counts[op];
+  }
+  member_count += counts[WL_MEMBER];
+  insert_count += counts[WL_INSERT];
+  delete_count += counts[WL_DELETE];
+  scan_count += counts[WL_SCAN];
+}
+
+/*-----------------------------------------------------------------*/
+void Print_phases(void) {
+  for (int p = 0; p < workload.phase_count; p++) {
+    long long ops = 0;
+    for (int op = 0; op < WL_OP_COUNT; op++) ops += phase_counts[p][op];
+    printf("Phase %d: %lld ops in %e seconds = %.0f ops/s (", p, ops,
+           phase_elapsed[p], ops / phase_elapsed[p]);
+    for (int op = 0; op < WL_OP_COUNT; op++) {
+      if (op == WL_SCAN && phase_counts[p][op] == 0) continue;
+      printf("%s%s %lld", op > 0 ? ", " : "", wl_op_name(op),
+             phase_counts[p][op]);
+    }
+    printf(")\n");
+  }
+}
+
+/*-----------------------------------------------------------------*/
+/* Runs one op on the set; with INSTRUMENT its latency goes into the
+ * calling thread's histogram */
+void Run_op(wl_op_t op, int key, long my_rank) {
+#ifdef INSTRUMENT
+  unsigned long long start_ns = lh_now_ns();
+#endif
+  switch (op) {
+    case WL_MEMBER:
+      backend->member(set, key, my_rank);
+      break;
+    case WL_INSERT:
+      backend->insert(set, key, my_rank);
+      break;
+    default: /* WL_DELETE */
+      backend->delete(set, key, my_rank);
+      break;
+  }
+#ifdef INSTRUMENT
+  lh_record(&op_latency[my_rank][op], lh_now_ns() - start_ns);
+#endif
+}
+
+/* Counts the keys in [low, low + range) with the backend's scan op;
+ * with INSTRUMENT its latency goes into the calling thread's histogram */
+void Run_scan(int low, long long range, long my_rank) {
+  long long high = low + range;
+#ifdef INSTRUMENT
+  unsigned long long start_ns = lh_now_ns();
+#endif
+  backend->scan(set, low, high < INT_MAX ? high : INT_MAX, my_rank);
+#ifdef INSTRUMENT
+  lh_record(&op_latency[my_rank][WL_SCAN], lh_now_ns() - start_ns);
+#endif
+}
+
+/*-----------------------------------------------------------------*/
+/* Runs op on key now, or with -B queues it in the calling thread's batch
+ * and runs the batch once it is full */
+void Submit(set_op_t* batch, int* batched_p, wl_op_t op, int key,
+            long my_rank) {
+  if (batch_size == 1) {
+    Run_op(op, key, my_rank);
+    return;
+  }
+  batch[(*batched_p)++] = (set_op_t){key, op, 0, 0};
+  if (*batched_p == batch_size) Flush(batch, batched_p, my_rank);
+}
+
+/* Runs the ops queued by Submit; with INSTRUMENT the latency of the
+ * whole batch goes into the calling thread's histogram */
+void Flush(set_op_t* batch, int* batched_p, long my_rank) {
+  if (*batched_p == 0) return;
+#ifdef INSTRUMENT
+  unsigned long long start_ns = lh_now_ns();
+#endif
+  Set_batch(batch, *batched_p, my_rank);
+#ifdef INSTRUMENT
+  lh_record(&op_latency[my_rank][WL_OP_COUNT], lh_now_ns() - start_ns);
+#endif
+  *batched_p = 0;
+}
+
+/*-----------------------------------------------------------------*/
+/* The backend's batch op, or its single ops one by one if it has none */
+int Set_batch(set_op_t* ops, int count, long rank) {
+  int successes = 0;
+
+  if (backend->batch != NULL) return backend->batch(set, ops, count, rank);
+  for (int b = 0; b < count; b++) {
+    ops[b].index = b;
+    switch (ops[b].op) {
+      case WL_MEMBER:
+        ops[b].result = backend->member(set, ops[b].key, rank);
+        break;
+      case WL_INSERT:
+        ops[b].result = backend->insert(set, ops[b].key, rank);
+        break;
+      default: /* WL_DELETE */
+        ops[b].result = backend->delete(set, ops[b].key, rank);
+        break;
+    }
+    successes += ops[b].result;
+  }
+  return successes;
+}
+
+#ifdef INSTRUMENT
+/*-----------------------------------------------------------------*/
+/* Merges the threads' histograms and prints them, then the statistics
+ * of the custom lock if the run used it */
+void Print_latencies(void) {
+  lh_hist_t total;
+  char name[64];
+
+  for (int op = 0; op <= WL_OP_COUNT; op++) {
+    lh_init(&total);
+    for (int r = 0; r < thread_count; r++) lh_merge(&total, &op_latency[r][op]);
+    if (total.count == 0) continue;
+    snprintf(name, sizeof(name), "%s latency (ns)",
+             op < WL_OP_COUNT ? wl_op_name(op) : "batch");
+    lh_print(&total, name, stdout);
+  }
+  if (backend != &rwlock_backend) return;
+  if (lock_kind == LOCK_MY) {
+    my_rwlock_print_stats(&rwlock, stdout);
+  } else if (lock_kind == LOCK_BRAVO) {
+    printf("Underlying lock (slow-path readers and writers only):\n");
+    my_rwlock_print_stats(&bravo_rwlock.underlying, stdout);
+  }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,264 @@
+/* File:     skiplist.c
+ *
+ * Purpose:  lock-free skip list set backend for rw_lock.c
+ *
+ * Notes:
+ * 1.  The algorithm is the lock-free skip list of Herlihy and Shavit
+ *     ("The Art of Multiprocessor Programming", 14.4), after Fraser.  The
+ *     low bit of a next pointer marks its node as deleted at that level;
+ *     a node is in the set iff it is reachable at level 0 and not marked
+ *     there.  Searches unlink ("snip") marked nodes they pass with CAS.
+ * 2.  Delete marks the levels top-down, and the thread whose mark lands
+ *     on level 0 is the one that deleted the key.  Member never writes.
+ * 3.  Unlinked nodes are freed through epoch-based reclamation.  A node
+ *     may only be retired once it is unreachable, but its inserter can
+ *     still be linking its upper levels after it has been deleted.  So
+ *     the inserter and the deleter each bump done when they are through,
+ *     and the second one unlinks the node with a search and retires it.
+ * 4.  Node heights are geometric with p = 1/2, drawn from a per-thread
+ *     xorshift generator.
+ */
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "epoch.h"
+#include "set_backend.h"
+
+#define SL_MAX_LEVEL 24
+#define SL_CACHE_LINE 64
+
+typedef struct sl_node {
+  int key;
+  int height;
+  _Atomic int done;                /* Inserter and deleter finished */
+  _Atomic uintptr_t next[];        /* Successors, low bit = mark */
+} sl_node_t;
+
+typedef struct {
+  uint32_t state;
+} __attribute__((aligned(SL_CACHE_LINE))) sl_rng_t;
+
+typedef struct {
+  sl_node_t* head; /* Key INT_MIN, full height */
+  sl_node_t* tail; /* Key INT_MAX, full height */
+  epoch_t epoch;
+  sl_rng_t* rng; /* One per thread */
+} skiplist_t;
+
+#define MARKED(p) ((p)&1)
+#define UNMARK(p) ((sl_node_t*)((p) & ~(uintptr_t)1))
+
+static sl_node_t* Node_new(int key, int height) {
+  sl_node_t* node =
+      malloc(sizeof(sl_node_t) + height * sizeof(_Atomic uintptr_t));
+  node->key = key;
+  node->height = height;
+  atomic_init(&node->done, 0);
+  return node;
+}
+
+static int Random_height(skiplist_t* list, long rank) {
+  uint32_t x = list->rng[rank].state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  list->rng[rank].state = x;
+
+  /* One more level for every trailing one bit, up to SL_MAX_LEVEL; the
+   * stop bit keeps ~x nonzero when x is all ones */
+  return 1 + __builtin_ctz(~x | (1u << (SL_MAX_LEVEL - 1)));
+}
+
+/* Fills preds and succs with the nodes around key at every level,
+ * unlinking marked nodes on the way; returns 1 if succs[0] has key */
+static int Find(skiplist_t* list, int key, sl_node_t** preds,
+                sl_node_t** succs) {
+retry:;
+  sl_node_t* pred = list->head;
+  for (int level = SL_MAX_LEVEL - 1; level >= 0; level--) {
+    sl_node_t* curr = UNMARK(atomic_load(&pred->next[level]));
+    for (;;) {
+      uintptr_t succ = atomic_load(&curr->next[level]);
+      while (MARKED(succ)) {
+        uintptr_t expected = (uintptr_t)curr;
+        if (!atomic_compare_exchange_strong(&pred->next[level], &expected,
+                                            (uintptr_t)UNMARK(succ))) {
+          goto retry;
+        }
+        curr = UNMARK(succ);
+        succ = atomic_load(&curr->next[level]);
+      }
+      if (curr->key < key) {
+        pred = curr;
+        curr = UNMARK(succ);
+      } else {
+        break;
+      }
+    }
+    preds[level] = pred;
+    succs[level] = curr;
+  }
+  return succs[0]->key == key;
+}
+
+/* Called by the inserter and the deleter of node when they are through
+ * with it; the second one unlinks and retires it */
+static void Finish(skiplist_t* list, sl_node_t* node, long rank) {
+  sl_node_t* preds[SL_MAX_LEVEL];
+  sl_node_t* succs[SL_MAX_LEVEL];
+
+  if (atomic_fetch_add(&node->done, 1) == 1) {
+    Find(list, node->key, preds, succs);
+    epoch_retire(&list->epoch, rank, node);
+  }
+}
+
+static void* Skiplist_create(int thread_count) {
+  skiplist_t* list = malloc(sizeof(skiplist_t));
+
+  list->head = Node_new(INT_MIN, SL_MAX_LEVEL);
+  list->tail = Node_new(INT_MAX, SL_MAX_LEVEL);
+  for (int level = 0; level < SL_MAX_LEVEL; level++) {
+    atomic_init(&list->head->next[level], (uintptr_t)list->tail);
+    atomic_init(&list->tail->next[level], (uintptr_t)NULL);
+  }
+  epoch_init(&list->epoch, thread_count, free);
+  list->rng = aligned_alloc(SL_CACHE_LINE, thread_count * sizeof(sl_rng_t));
+  for (int r = 0; r < thread_count; r++) {
+    list->rng[r].state = 2463534242u + 97u * r;
+  }
+  return list;
+}
+
+static int Skiplist_insert(void* set, int value, long rank) {
+  skiplist_t* list = set;
+  sl_node_t* preds[SL_MAX_LEVEL];
+  sl_node_t* succs[SL_MAX_LEVEL];
+  int height = Random_height(list, rank);
+  sl_node_t* node = Node_new(value, height);
+
+  epoch_enter(&list->epoch, rank);
+  for (;;) {
+    if (Find(list, value, preds, succs)) {
+      epoch_exit(&list->epoch, rank);
+      free(node); /* Never published */
+      return 0;
+    }
+    for (int level = 0; level < height; level++) {
+      atomic_store_explicit(&node->next[level], (uintptr_t)succs[level],
+                            memory_order_relaxed);
+    }
+    uintptr_t expected = (uintptr_t)succs[0];
+    if (atomic_compare_exchange_strong(&preds[0]->next[0], &expected,
+                                       (uintptr_t)node)) {
+      break;
+    }
+  }
+
+  /* The key is in the set now; link the upper levels */
+  for (int level = 1; level < height; level++) {
+    for (;;) {
+      uintptr_t next = atomic_load(&node->next[level]);
+      if (MARKED(next)) goto done; /* Deleted meanwhile */
+      if (UNMARK(next) != succs[level] &&
+          !atomic_compare_exchange_strong(&node->next[level], &next,
+                                          (uintptr_t)succs[level])) {
+        continue;
+      }
+      uintptr_t expected = (uintptr_t)succs[level];
+      if (atomic_compare_exchange_strong(&preds[level]->next[level], &expected,
+                                         (uintptr_t)node)) {
+        break;
+      }
+      Find(list, value, preds, succs);
+      if (succs[0] != node) goto done; /* Deleted and unlinked */
+    }
+  }
+done:
+  Finish(list, node, rank);
+  epoch_exit(&list->epoch, rank);
+  return 1;
+}
+
+static int Skiplist_member(void* set, int value, long rank) {
+  skiplist_t* list = set;
+  sl_node_t* pred = list->head;
+  sl_node_t* curr = NULL;
+
+  epoch_enter(&list->epoch, rank);
+  for (int level = SL_MAX_LEVEL - 1; level >= 0; level--) {
+    curr = UNMARK(atomic_load(&pred->next[level]));
+    for (;;) {
+      uintptr_t succ = atomic_load(&curr->next[level]);
+      while (MARKED(succ)) {
+        curr = UNMARK(succ);
+        succ = atomic_load(&curr->next[level]);
+      }
+      if (curr->key < value) {
+        pred = curr;
+        curr = UNMARK(succ);
+      } else {
+        break;
+      }
+    }
+  }
+  int found = curr->key == value && !MARKED(atomic_load(&curr->next[0]));
+  epoch_exit(&list->epoch, rank);
+  return found;
+}
+
+static int Skiplist_delete(void* set, int value, long rank) {
+  skiplist_t* list = set;
+  sl_node_t* preds[SL_MAX_LEVEL];
+  sl_node_t* succs[SL_MAX_LEVEL];
+
+  epoch_enter(&list->epoch, rank);
+  if (!Find(list, value, preds, succs)) {
+    epoch_exit(&list->epoch, rank);
+    return 0;
+  }
+  sl_node_t* node = succs[0];
+
+  for (int level = node->height - 1; level >= 1; level--) {
+    uintptr_t next = atomic_load(&node->next[level]);
+    while (!MARKED(next) && !atomic_compare_exchange_weak(
+                                &node->next[level], &next, next | 1)) {
+    }
+  }
+
+  uintptr_t next = atomic_load(&node->next[0]);
+  for (;;) {
+    if (MARKED(next)) { /* Another thread deleted it first */
+      epoch_exit(&list->epoch, rank);
+      return 0;
+    }
+    if (atomic_compare_exchange_weak(&node->next[0], &next, next | 1)) break;
+  }
+
+  Finish(list, node, rank);
+  epoch_exit(&list->epoch, rank);
+  return 1;
+}
+
+static void Skiplist_destroy(void* set) {
+  skiplist_t* list = set;
+  sl_node_t* curr = UNMARK(atomic_load(&list->head->next[0]));
+
+  /* Nodes still linked at level 0, marked or not, have not been retired */
+  while (curr != list->tail) {
+    sl_node_t* next = UNMARK(atomic_load(&curr->next[0]));
+    free(curr);
+    curr = next;
+  }
+  epoch_destroy(&list->epoch);
+  free(list->head);
+  free(list->tail);
+  free(list->rng);
+  free(list);
+}
+
+const set_backend_t skiplist_backend = {
+    "skiplist",     Skiplist_create, Skiplist_insert,
+    Skiplist_member, Skiplist_delete, Skiplist_destroy};
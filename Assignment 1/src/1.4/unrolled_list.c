@@ -0,0 +1,235 @@
+/* File:     unrolled_list.c
+ *
+ * Purpose:  sorted set of ints in a linked list of blocks of keys, the
+ *           structure rw_lock.c uses with -s unrolled
+ *
+ * ul_init, ul_destroy:            set up / free every block
+ * ul_insert, ul_member, ul_delete:  as Insert, Member and Delete in
+ *                                 rw_lock.c
+ * ul_apply_batch:                 ops sorted by key, in a single pass
+ * ul_scan:                        how many keys are in [low, high)
+ * ul_print:                       the keys in order
+ *
+ * Notes:
+ * 1.  A search follows one next pointer per block of up to 56 keys
+ *     instead of one per key, and reads the blocks' first keys on the
+ *     way, so a traversal costs about 1/50th of the cache misses.
+ * 2.  Within a block the position of value is the number of keys below
+ *     it, counted with compare masks over GCC vectors (AVX2 or SSE2
+ *     registers) of all UL_BLOCK_KEYS slots, without branches.
+ * 3.  ul_apply_batch keeps a cursor block across the ops, which only
+ *     moves forward, like Apply_batch in rw_lock.c.
+ */
+#include "unrolled_list.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Ints per vector: a whole AVX2 register if the target has one */
+#ifdef __AVX2__
+#define UL_WIDTH 8
+#else
+#define UL_WIDTH 4
+#endif
+
+typedef int vec_t __attribute__((vector_size(UL_WIDTH * sizeof(int))));
+
+_Static_assert(sizeof(ul_block_t) == UL_BLOCK_BYTES, "block size");
+_Static_assert(UL_BLOCK_KEYS % UL_WIDTH == 0, "keys per block");
+
+static ul_block_t* Block_new(void) {
+  ul_block_t* block = aligned_alloc(64, sizeof(ul_block_t));
+
+  for (int i = 0; i < UL_BLOCK_KEYS; i++) block->keys[i] = INT_MAX;
+  block->count = 0;
+  block->next = NULL;
+  return block;
+}
+
+/* Number of keys of block below value, i.e. where value is or goes */
+static int Rank(const ul_block_t* block, int value) {
+  vec_t target = (vec_t){} + value;
+  vec_t below = {};
+
+  for (int i = 0; i < UL_BLOCK_KEYS; i += UL_WIDTH) {
+    vec_t keys;
+    memcpy(&keys, &block->keys[i], sizeof(keys));
+    below -= keys < target; /* Lanes of the mask are -1 or 0 */
+  }
+  int rank = 0;
+  for (int l = 0; l < UL_WIDTH; l++) rank += below[l];
+  return rank;
+}
+
+/* Moves on from block to the last block whose first key is <= value,
+ * updating *pred_p to the block before it */
+static ul_block_t* Locate(ul_block_t* block, ul_block_t** pred_p,
+                          int value) {
+  while (block->next != NULL && block->next->keys[0] <= value) {
+    *pred_p = block;
+    block = block->next;
+  }
+  return block;
+}
+
+static int Contains(const ul_block_t* block, int value) {
+  int pos = Rank(block, value);
+  return pos < block->count && block->keys[pos] == value;
+}
+
+/* Inserts value in block, splitting it first if it is full */
+static int Insert_in(ul_block_t* block, int value) {
+  int pos = Rank(block, value);
+
+  if (pos < block->count && block->keys[pos] == value) return 0;
+  if (block->count == UL_BLOCK_KEYS) {
+    ul_block_t* upper = Block_new();
+    int half = UL_BLOCK_KEYS / 2;
+
+    memcpy(upper->keys, &block->keys[half],
+           (UL_BLOCK_KEYS - half) * sizeof(int));
+    upper->count = UL_BLOCK_KEYS - half;
+    for (int i = half; i < UL_BLOCK_KEYS; i++) block->keys[i] = INT_MAX;
+    block->count = half;
+    upper->next = block->next;
+    block->next = upper;
+    if (pos > half) {
+      block = upper;
+      pos -= half;
+    }
+  }
+  memmove(&block->keys[pos + 1], &block->keys[pos],
+          (block->count - pos) * sizeof(int));
+  block->keys[pos] = value;
+  block->count++;
+  return 1;
+}
+
+/* Deletes value from *block_p.  An underflow is fixed with the next
+ * block; an emptied last block is freed, and then *block_p becomes its
+ * predecessor and *pred_p NULL (unknown) */
+static int Delete_in(ul_block_t** block_p, ul_block_t** pred_p, int value) {
+  ul_block_t* block = *block_p;
+  ul_block_t* next = block->next;
+  int pos = Rank(block, value);
+
+  if (pos >= block->count || block->keys[pos] != value) return 0;
+  memmove(&block->keys[pos], &block->keys[pos + 1],
+          (block->count - pos - 1) * sizeof(int));
+  block->keys[--block->count] = INT_MAX;
+  if (block->count >= UL_MIN_KEYS) return 1;
+
+  if (next != NULL) {
+    /* Absorb next if both fit in one block, else even them out */
+    int moved = next->count;
+    if (block->count + next->count > UL_BLOCK_KEYS) {
+      moved = (next->count - block->count) / 2;
+    }
+    memcpy(&block->keys[block->count], next->keys, moved * sizeof(int));
+    block->count += moved;
+    memmove(next->keys, &next->keys[moved],
+            (next->count - moved) * sizeof(int));
+    for (int i = next->count - moved; i < next->count; i++) {
+      next->keys[i] = INT_MAX;
+    }
+    next->count -= moved;
+    if (next->count == 0) {
+      block->next = next->next;
+      free(next);
+    }
+  } else if (block->count == 0 && *pred_p != NULL) {
+    (*pred_p)->next = NULL;
+    *block_p = *pred_p;
+    *pred_p = NULL;
+    free(block);
+  }
+  return 1;
+}
+
+/* Function:      ul_init
+ * Out arg:       list, empty
+ * Return value:  0 on success, -1 if allocation fails
+ */
+int ul_init(unrolled_list_t* list) {
+  list->head = Block_new();
+  return list->head == NULL ? -1 : 0;
+}
+
+void ul_destroy(unrolled_list_t* list) {
+  ul_block_t* block = list->head;
+
+  while (block != NULL) {
+    ul_block_t* next = block->next;
+    free(block);
+    block = next;
+  }
+  list->head = NULL;
+}
+
+int ul_insert(unrolled_list_t* list, int value) {
+  ul_block_t* pred = NULL;
+  return Insert_in(Locate(list->head, &pred, value), value);
+}
+
+int ul_member(const unrolled_list_t* list, int value) {
+  ul_block_t* pred = NULL;
+  return Contains(Locate(list->head, &pred, value), value);
+}
+
+int ul_delete(unrolled_list_t* list, int value) {
+  ul_block_t* pred = NULL;
+  ul_block_t* block = Locate(list->head, &pred, value);
+  return Delete_in(&block, &pred, value);
+}
+
+/* Function:      ul_apply_batch
+ * In args:       count
+ * In/out args:   list, ops (sorted by key; results set)
+ * Return value:  how many ops returned 1
+ */
+int ul_apply_batch(unrolled_list_t* list, set_op_t* ops, int count) {
+  ul_block_t* block = list->head;
+  ul_block_t* pred = NULL;
+  int successes = 0;
+
+  for (int b = 0; b < count; b++) {
+    int value = ops[b].key;
+    block = Locate(block, &pred, value);
+    switch (ops[b].op) {
+      case WL_MEMBER:
+        ops[b].result = Contains(block, value);
+        break;
+      case WL_INSERT:
+        ops[b].result = Insert_in(block, value);
+        break;
+      default: /* WL_DELETE */
+        ops[b].result = Delete_in(&block, &pred, value);
+        break;
+    }
+    successes += ops[b].result;
+  }
+  return successes;
+}
+
+int ul_scan(const unrolled_list_t* list, int low, int high) {
+  ul_block_t* pred = NULL;
+  const ul_block_t* block = Locate(list->head, &pred, low);
+  int count = -Rank(block, low);
+
+  /* Whole blocks until the one that holds high */
+  while (block->next != NULL && block->next->keys[0] < high) {
+    count += block->count;
+    block = block->next;
+  }
+  return count + Rank(block, high);
+}
+
+void ul_print(const unrolled_list_t* list, FILE* stream) {
+  for (const ul_block_t* block = list->head; block != NULL;
+       block = block->next) {
+    for (int i = 0; i < block->count; i++) {
+      fprintf(stream, "%d ", block->keys[i]);
+    }
+  }
+}
@@ -0,0 +1,128 @@
+/* File:     bravo_rwlock.c
+ *
+ * Purpose:  implement a reader-biased distributed reader-writer lock
+ *           (BRAVO, Dice and Kogan, USENIX ATC 2019) on top of my_rwlock_t
+ *
+ * bravo_rwlock_init, bravo_rwlock_destroy:  set up / tear down
+ * bravo_rdlock, bravo_rdunlock:             read lock of thread rank
+ * bravo_wrlock, bravo_wrunlock:             write lock
+ *
+ * Notes:
+ * 1.  Fast path: a reader sets its slot, then checks read_bias.  A writer
+ *     clears read_bias, then waits for every slot to clear.  Both sides
+ *     store before they load with sequentially consistent atomics, so
+ *     either the reader sees the bias gone (and backs out) or the writer
+ *     sees the slot set (and waits).
+ * 2.  Slow path: with the bias off a reader takes the underlying lock,
+ *     and so waits for writers according to its priority mode.  Holding
+ *     it, and with no writer around, the reader turns the bias back on.
+ * 3.  Revocation costs the writer a scan of all slots, so after one the
+ *     bias stays off for BRAVO_INHIBIT_FACTOR times as long as the
+ *     revocation took.  Write-heavy phases then run on the underlying
+ *     lock alone.
+ * 4.  Writers announce themselves in writers before taking the
+ *     underlying lock, and readers do not re-enable the bias while one is
+ *     around, so under WRITE_PRIORITY fast-path readers cannot overtake a
+ *     waiting writer either.
+ */
+#include "bravo_rwlock.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BRAVO_INHIBIT_FACTOR 9
+
+static long long Now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Function:      bravo_rwlock_init
+ * In args:       priority_mode (READ_PRIORITY or WRITE_PRIORITY),
+ *                thread_count
+ * Out arg:       lock
+ * Return value:  0 on success, -1 if allocation fails
+ */
+int bravo_rwlock_init(bravo_rwlock_t* lock, int priority_mode,
+                      int thread_count) {
+  lock->slots =
+      aligned_alloc(BRAVO_CACHE_LINE, thread_count * sizeof(bravo_slot_t));
+  if (lock->slots == NULL) return -1;
+  for (int r = 0; r < thread_count; r++) {
+    atomic_init(&lock->slots[r].reading, 0);
+  }
+  atomic_init(&lock->read_bias, 1);
+  atomic_init(&lock->writers, 0);
+  lock->inhibit_until_ns = 0;
+  lock->thread_count = thread_count;
+  my_rwlock_init(&lock->underlying, priority_mode);
+  return 0;
+}
+
+void bravo_rwlock_destroy(bravo_rwlock_t* lock) {
+  my_rwlock_destroy(&lock->underlying);
+  free(lock->slots);
+  lock->slots = NULL;
+}
+
+void bravo_rdlock(bravo_rwlock_t* lock, long rank) {
+  bravo_slot_t* slot = &lock->slots[rank];
+
+  if (atomic_load(&lock->read_bias)) {
+    atomic_store(&slot->reading, 1);
+    if (atomic_load(&lock->read_bias)) return;
+    atomic_store(&slot->reading, 0); /* Revoked meanwhile */
+  }
+
+  my_rwlock_rdlock(&lock->underlying);
+  /* inhibit_until_ns is only written under the write lock */
+  if (!atomic_load_explicit(&lock->read_bias, memory_order_relaxed) &&
+      atomic_load(&lock->writers) == 0 && Now_ns() >= lock->inhibit_until_ns) {
+    atomic_store(&lock->read_bias, 1);
+  }
+}
+
+void bravo_rdunlock(bravo_rwlock_t* lock, long rank) {
+  bravo_slot_t* slot = &lock->slots[rank];
+
+  if (atomic_load_explicit(&slot->reading, memory_order_relaxed)) {
+    atomic_store_explicit(&slot->reading, 0, memory_order_release);
+  } else {
+    my_rwlock_unlock(&lock->underlying);
+  }
+}
+
+void bravo_wrlock(bravo_rwlock_t* lock) {
+  int revoked = 0;
+
+  atomic_fetch_add(&lock->writers, 1);
+  /* Stop new fast-path readers while waiting for the underlying lock */
+  if (atomic_load(&lock->read_bias)) {
+    atomic_store(&lock->read_bias, 0);
+    revoked = 1;
+  }
+  my_rwlock_wrlock(&lock->underlying);
+  /* A slow-path reader may have turned the bias on again meanwhile */
+  if (atomic_load(&lock->read_bias)) {
+    atomic_store(&lock->read_bias, 0);
+    revoked = 1;
+  }
+
+  /* Scan even if this writer did not revoke: the writer that did may
+   * still be waiting for the underlying lock */
+  long long start = Now_ns();
+  for (int r = 0; r < lock->thread_count; r++) {
+    while (atomic_load(&lock->slots[r].reading)) sched_yield();
+  }
+  if (revoked) {
+    long long now = Now_ns();
+    lock->inhibit_until_ns = now + BRAVO_INHIBIT_FACTOR * (now - start);
+  }
+}
+
+void bravo_wrunlock(bravo_rwlock_t* lock) {
+  atomic_fetch_sub(&lock->writers, 1);
+  my_rwlock_unlock(&lock->underlying);
+}
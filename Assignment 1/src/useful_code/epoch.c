@@ -0,0 +1,138 @@
+/* File:     epoch.c
+ *
+ * Purpose:  implement epoch-based reclamation (Fraser, "Practical
+ *           lock-freedom", 2004)
+ *
+ * epoch_init, epoch_destroy:  set up / tear down, freeing all retired items
+ * epoch_enter, epoch_exit:    bracket an operation of thread rank
+ * epoch_retire:               free item once no operation can see it
+ *
+ * Notes:
+ * 1.  A thread inside an operation announces the global epoch it saw.
+ *     The global epoch only moves from e to e+1 once every thread inside
+ *     an operation has announced e.  An item is tagged with the global
+ *     epoch e when it is retired; threads inside an operation then have
+ *     announced e or e-1.  Once the global epoch reaches e+2 all of them
+ *     have left, every later operation started after the unlink, and the
+ *     item is freed.
+ * 2.  Each thread keeps its retired items in three lists, one per epoch
+ *     modulo 3; a list is reused (and its items freed) once its epoch is
+ *     two behind the global one.
+ * 3.  A thread tries to advance the global epoch every
+ *     EPOCH_ADVANCE_INTERVAL retirements.  A thread that stalls inside an
+ *     operation holds back reclamation, but never the other threads'
+ *     progress.
+ */
+#include "epoch.h"
+
+#include <stdlib.h>
+
+#define EPOCH_ADVANCE_INTERVAL 64
+
+static void Free_limbo(epoch_t* epoch, epoch_limbo_t* limbo) {
+  for (size_t i = 0; i < limbo->count; i++) epoch->free_fn(limbo->items[i]);
+  limbo->count = 0;
+}
+
+/* Frees the lists of slot that were retired at least two epochs before
+ * global */
+static void Reclaim(epoch_t* epoch, epoch_slot_t* slot, unsigned long global) {
+  for (int l = 0; l < 3; l++) {
+    epoch_limbo_t* limbo = &slot->limbo[l];
+    if (limbo->count > 0 && limbo->epoch + 2 <= global) {
+      Free_limbo(epoch, limbo);
+    }
+  }
+}
+
+/* Moves the global epoch on if every thread inside an operation has seen
+ * the current one */
+static void Try_advance(epoch_t* epoch) {
+  unsigned long global = atomic_load(&epoch->global);
+
+  for (int r = 0; r < epoch->thread_count; r++) {
+    unsigned long state = atomic_load(&epoch->slots[r].state);
+    if ((state & 1) && (state >> 1) != global) return;
+  }
+  atomic_compare_exchange_strong(&epoch->global, &global, global + 1);
+}
+
+/* Function:      epoch_init
+ * In args:       thread_count, free_fn (frees one retired item)
+ * Out arg:       epoch
+ * Return value:  0 on success, -1 if allocation fails
+ */
+int epoch_init(epoch_t* epoch, int thread_count, void (*free_fn)(void*)) {
+  epoch->slots =
+      aligned_alloc(EPOCH_CACHE_LINE, thread_count * sizeof(epoch_slot_t));
+  if (epoch->slots == NULL) return -1;
+  atomic_init(&epoch->global, 2);
+  epoch->thread_count = thread_count;
+  epoch->free_fn = free_fn;
+  for (int r = 0; r < thread_count; r++) {
+    epoch_slot_t* slot = &epoch->slots[r];
+    atomic_init(&slot->state, 0);
+    slot->retired_since_advance = 0;
+    for (int l = 0; l < 3; l++) {
+      slot->limbo[l] = (epoch_limbo_t){NULL, 0, 0, 0};
+    }
+  }
+  return 0;
+}
+
+/* Function:   epoch_destroy
+ * In/out arg: epoch, with no thread inside an operation
+ */
+void epoch_destroy(epoch_t* epoch) {
+  for (int r = 0; r < epoch->thread_count; r++) {
+    for (int l = 0; l < 3; l++) {
+      Free_limbo(epoch, &epoch->slots[r].limbo[l]);
+      free(epoch->slots[r].limbo[l].items);
+    }
+  }
+  free(epoch->slots);
+  epoch->slots = NULL;
+}
+
+void epoch_enter(epoch_t* epoch, long rank) {
+  epoch_slot_t* slot = &epoch->slots[rank];
+  unsigned long global = atomic_load(&epoch->global);
+
+  /* Sequentially consistent, so the announcement is visible before any
+   * pointer of the structure is read */
+  atomic_store(&slot->state, (global << 1) | 1);
+  Reclaim(epoch, slot, global);
+}
+
+void epoch_exit(epoch_t* epoch, long rank) {
+  atomic_store_explicit(&epoch->slots[rank].state, 0, memory_order_release);
+}
+
+/* Function:   epoch_retire
+ * In args:    rank (inside an operation), item (already unlinked)
+ * In/out arg: epoch
+ */
+void epoch_retire(epoch_t* epoch, long rank, void* item) {
+  epoch_slot_t* slot = &epoch->slots[rank];
+  unsigned long now = atomic_load(&epoch->global);
+  epoch_limbo_t* limbo = &slot->limbo[now % 3];
+
+  /* The list still holds items of epoch now - 3, which are safe by now */
+  if (limbo->epoch != now) {
+    Free_limbo(epoch, limbo);
+    limbo->epoch = now;
+  }
+  if (limbo->count == limbo->capacity) {
+    size_t capacity = limbo->capacity ? 2 * limbo->capacity : 64;
+    void** items = realloc(limbo->items, capacity * sizeof(void*));
+    if (items == NULL) return; /* Leak rather than free too early */
+    limbo->items = items;
+    limbo->capacity = capacity;
+  }
+  limbo->items[limbo->count++] = item;
+
+  if (++slot->retired_since_advance >= EPOCH_ADVANCE_INTERVAL) {
+    slot->retired_since_advance = 0;
+    Try_advance(epoch);
+  }
+}
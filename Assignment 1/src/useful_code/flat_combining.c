@@ -0,0 +1,137 @@
+/* File:     flat_combining.c
+ *
+ * Purpose:  implement flat combining for the set operations of
+ *           set_backend.h
+ *
+ * fc_init, fc_destroy:  set up / tear down
+ * fc_execute:           run one op of thread rank, returning its result
+ * fc_execute_batch:     run a batch of thread rank as combiner
+ *
+ * Notes:
+ * 1.  A waiting thread only reads its own slot and the combiner flag, so
+ *     while one thread combines, the others generate no coherence
+ *     traffic on the structure or on a lock.
+ * 2.  The combiner makes up to FC_MAX_PASSES passes over the slots, so
+ *     ops published while it applies the first batch are picked up
+ *     without another handoff of the flag.
+ * 3.  Waiters spin FC_SPINS_BEFORE_YIELD times, then yield on every
+ *     check, so the combiner gets the CPU on oversubscribed hosts.
+ */
+#include "flat_combining.h"
+
+#include <sched.h>
+#include <stdlib.h>
+
+#define FC_MAX_PASSES 3
+#define FC_SPINS_BEFORE_YIELD 128
+
+/* Function:      fc_init
+ * In args:       thread_count, apply (runs a batch of ops), context
+ *                (passed to apply)
+ * Out arg:       fc
+ * Return value:  0 on success, -1 if allocation fails
+ */
+int fc_init(flat_combiner_t* fc, int thread_count, fc_apply_fn apply,
+            void* context) {
+  fc->slots = aligned_alloc(FC_CACHE_LINE, thread_count * sizeof(fc_slot_t));
+  fc->scratch = malloc(thread_count * sizeof(set_op_t));
+  if (fc->slots == NULL || fc->scratch == NULL) {
+    free(fc->slots);
+    free(fc->scratch);
+    return -1;
+  }
+  for (int r = 0; r < thread_count; r++) atomic_init(&fc->slots[r].pending, 0);
+  atomic_init(&fc->combiner, 0);
+  fc->thread_count = thread_count;
+  fc->apply = apply;
+  fc->context = context;
+  fc->passes = fc->combined = 0;
+  return 0;
+}
+
+void fc_destroy(flat_combiner_t* fc) {
+  free(fc->slots);
+  free(fc->scratch);
+  fc->slots = NULL;
+  fc->scratch = NULL;
+}
+
+/* Takes the combiner flag if it is free */
+static int Try_combine(flat_combiner_t* fc) {
+  return atomic_load_explicit(&fc->combiner, memory_order_relaxed) == 0 &&
+         atomic_exchange_explicit(&fc->combiner, 1, memory_order_acquire) == 0;
+}
+
+/* Applies the published ops; called with the combiner flag held */
+static void Combine(flat_combiner_t* fc, long rank) {
+  for (int pass = 0; pass < FC_MAX_PASSES; pass++) {
+    int count = 0;
+    for (int r = 0; r < fc->thread_count; r++) {
+      fc_slot_t* slot = &fc->slots[r];
+      if (atomic_load_explicit(&slot->pending, memory_order_acquire)) {
+        fc->scratch[count] = slot->op;
+        fc->scratch[count].index = r;
+        count++;
+      }
+    }
+    if (count == 0) return;
+
+    fc->apply(fc->context, fc->scratch, count, rank);
+    for (int i = 0; i < count; i++) {
+      fc_slot_t* slot = &fc->slots[fc->scratch[i].index];
+      slot->op.result = fc->scratch[i].result;
+      atomic_store_explicit(&slot->pending, 0, memory_order_release);
+    }
+    fc->passes++;
+    fc->combined += count;
+  }
+}
+
+/* Function:      fc_execute
+ * In args:       rank, op, key
+ * In/out arg:    fc
+ * Return value:  what the single op would have returned
+ */
+int fc_execute(flat_combiner_t* fc, long rank, wl_op_t op, int key) {
+  fc_slot_t* slot = &fc->slots[rank];
+
+  slot->op.key = key;
+  slot->op.op = op;
+  atomic_store_explicit(&slot->pending, 1, memory_order_release);
+
+  for (int spins = 0;; spins++) {
+    if (Try_combine(fc)) {
+      Combine(fc, rank); /* Its first pass takes our op */
+      atomic_store_explicit(&fc->combiner, 0, memory_order_release);
+    }
+    if (!atomic_load_explicit(&slot->pending, memory_order_acquire)) {
+      return slot->op.result;
+    }
+    if (spins >= FC_SPINS_BEFORE_YIELD) sched_yield();
+  }
+}
+
+/* Function:      fc_execute_batch
+ * Purpose:       wait for the combiner flag, apply ops (index set to
+ *                their position), then serve the published ops
+ * In args:       rank, count
+ * In/out args:   fc, ops (order left to apply)
+ * Return value:  how many ops returned 1
+ */
+int fc_execute_batch(flat_combiner_t* fc, long rank, set_op_t* ops,
+                     int count) {
+  int successes = 0;
+
+  for (int b = 0; b < count; b++) ops[b].index = b;
+  for (int spins = 0; !Try_combine(fc); spins++) {
+    if (spins >= FC_SPINS_BEFORE_YIELD) sched_yield();
+  }
+  fc->apply(fc->context, ops, count, rank);
+  fc->passes++;
+  fc->combined += count;
+  Combine(fc, rank);
+  atomic_store_explicit(&fc->combiner, 0, memory_order_release);
+
+  for (int b = 0; b < count; b++) successes += ops[b].result;
+  return successes;
+}
@@ -0,0 +1,67 @@
+/* File:     latency_hist.c
+ *
+ * Purpose:  merge, query and print the log-linear histograms of
+ *           latency_hist.h
+ *
+ * lh_init:        empty a histogram
+ * lh_merge:       add the values of one histogram to another
+ * lh_percentile:  value below which percent of the values lie
+ * lh_print:       one line with count, mean, p50, p99, p99.9 and max
+ *
+ * Notes:
+ * 1.  lh_percentile returns the highest value of the bucket the
+ *     percentile falls in (as HdrHistogram does), capped at the largest
+ *     recorded value, so it overstates by at most one bucket width.
+ */
+#include "latency_hist.h"
+
+#include <string.h>
+
+void lh_init(lh_hist_t* hist) { memset(hist, 0, sizeof(*hist)); }
+
+void lh_merge(lh_hist_t* dst, const lh_hist_t* src) {
+  for (int b = 0; b < LH_BUCKETS; b++) dst->counts[b] += src->counts[b];
+  dst->count += src->count;
+  dst->sum += src->sum;
+  if (src->max > dst->max) dst->max = src->max;
+}
+
+/* Highest value that falls in bucket index */
+static unsigned long long Bucket_top(int index) {
+  if (index < LH_SUB_COUNT) return index;
+  int shift = index / LH_SUB_COUNT - 1;
+  unsigned long long base =
+      (unsigned long long)(LH_SUB_COUNT + index % LH_SUB_COUNT) << shift;
+  return base + ((1ULL << shift) - 1);
+}
+
+/* Function:      lh_percentile
+ * In args:       hist, percent (0 ... 100)
+ * Return value:  the percent-th percentile of the recorded values, 0 if
+ *                there are none
+ */
+unsigned long long lh_percentile(const lh_hist_t* hist, double percent) {
+  if (hist->count == 0) return 0;
+  unsigned long long rank =
+      (unsigned long long)(percent / 100.0 * hist->count + 0.5);
+  unsigned long long seen = 0;
+
+  if (rank < 1) rank = 1;
+  for (int b = 0; b < LH_BUCKETS; b++) {
+    seen += hist->counts[b];
+    if (seen >= rank) {
+      unsigned long long top = Bucket_top(b);
+      return top < hist->max ? top : hist->max;
+    }
+  }
+  return hist->max;
+}
+
+void lh_print(const lh_hist_t* hist, const char* name, FILE* stream) {
+  fprintf(stream,
+          "%s: count %llu, mean %.1f, p50 %llu, p99 %llu, p99.9 %llu, "
+          "max %llu\n",
+          name, hist->count, hist->count ? hist->sum / hist->count : 0.0,
+          lh_percentile(hist, 50.0), lh_percentile(hist, 99.0),
+          lh_percentile(hist, 99.9), hist->max);
+}
@@ -0,0 +1,267 @@
+/* File:     locks.c
+ *
+ * Purpose:  implement the locks of locks.h
+ *
+ * lock_init, lock_destroy:       set up / release a lock of a given kind
+ * lock_lock, lock_unlock:        acquire / release it
+ * lock_node_init, lock_node_destroy:  per-thread state of the queue locks
+ * lock_kind_parse, lock_kind_name:    convert kinds from / to names
+ *
+ * Notes:
+ * 1.  TTAS spins on a plain load, which hits in the own cache, and only
+ *     tries the exchange once the lock looks free.  After a failed
+ *     exchange it backs off for a random time that doubles up to
+ *     LOCK_MAX_BACKOFF pause instructions, so the waiters do not all
+ *     retry at once.
+ * 2.  The ticket lock hands the lock over in arrival order.  Waiters pause
+ *     in proportion to their distance from the head of the queue.
+ * 3.  MCS and CLH form an explicit queue in which every waiter spins on a
+ *     different cache line, so a release invalidates only the next
+ *     waiter's line.  MCS waiters spin on their own node, CLH waiters on
+ *     the cell of their predecessor; on release a CLH thread takes over
+ *     its predecessor's cell for its next acquisition.
+ * 4.  All waiting loops yield the processor after LOCK_SPINS_BEFORE_YIELD
+ *     spins.  With more threads than cores a FIFO lock would otherwise
+ *     stall for a whole time slice whenever the next thread in line has
+ *     been preempted.
+ */
+#include "locks.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOCK_MIN_BACKOFF 4
+#define LOCK_MAX_BACKOFF 1024
+#define LOCK_SPINS_BEFORE_YIELD 1024
+
+static const char* lock_names[] = {"mutex", "ttas", "ticket", "mcs", "clh"};
+
+static inline void Cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+/* One step of a waiting loop; spins counts the steps taken so far */
+static inline void Spin_wait(unsigned* spins) {
+  if (++*spins < LOCK_SPINS_BEFORE_YIELD) {
+    Cpu_relax();
+  } else {
+    *spins = 0;
+    sched_yield();
+  }
+}
+
+static lock_cell_t* Cell_new(int locked) {
+  lock_cell_t* cell = aligned_alloc(LOCK_CACHE_LINE, sizeof(lock_cell_t));
+  if (cell != NULL) atomic_init(&cell->locked, locked);
+  return cell;
+}
+
+/* Function:      lock_init
+ * In args:       kind
+ * Out arg:       lock
+ * Return value:  0 on success, -1 if kind is unknown or allocation fails
+ */
+int lock_init(lock_t* lock, lock_kind_t kind) {
+  memset(lock, 0, sizeof(*lock));
+  lock->kind = kind;
+
+  switch (kind) {
+    case LOCK_MUTEX:
+      return pthread_mutex_init(&lock->mutex, NULL) == 0 ? 0 : -1;
+    case LOCK_TTAS:
+      atomic_init(&lock->flag, 0);
+      return 0;
+    case LOCK_TICKET:
+      atomic_init(&lock->next_ticket, 0);
+      atomic_init(&lock->now_serving, 0);
+      return 0;
+    case LOCK_MCS:
+      atomic_init(&lock->mcs_tail, NULL);
+      return 0;
+    case LOCK_CLH: {
+      /* The queue starts with a released dummy cell */
+      lock_cell_t* dummy = Cell_new(0);
+      if (dummy == NULL) return -1;
+      atomic_init(&lock->clh_tail, dummy);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/* Function:   lock_destroy
+ * In/out arg: lock, which must not be held
+ */
+void lock_destroy(lock_t* lock) {
+  if (lock->kind == LOCK_MUTEX) {
+    pthread_mutex_destroy(&lock->mutex);
+  } else if (lock->kind == LOCK_CLH) {
+    /* The last cell released belongs to no thread */
+    free(atomic_load(&lock->clh_tail));
+  }
+}
+
+/* Function:   lock_lock
+ * In/out args: lock, node (the calling thread's)
+ */
+void lock_lock(lock_t* lock, lock_node_t* node) {
+  switch (lock->kind) {
+    case LOCK_MUTEX:
+      pthread_mutex_lock(&lock->mutex);
+      break;
+
+    case LOCK_TTAS: {
+      unsigned backoff = LOCK_MIN_BACKOFF, spins = 0;
+      unsigned seed = (unsigned)(size_t)node;
+      for (;;) {
+        while (atomic_load_explicit(&lock->flag, memory_order_relaxed)) {
+          Spin_wait(&spins);
+        }
+        if (!atomic_exchange_explicit(&lock->flag, 1, memory_order_acquire)) {
+          break;
+        }
+        seed = seed * 1103515245 + 12345;
+        for (unsigned i = (seed >> 16) % backoff; i > 0; i--) Cpu_relax();
+        if (backoff < LOCK_MAX_BACKOFF) backoff *= 2;
+      }
+      break;
+    }
+
+    case LOCK_TICKET: {
+      unsigned ticket = atomic_fetch_add_explicit(&lock->next_ticket, 1,
+                                                  memory_order_relaxed);
+      unsigned spins = 0;
+      for (;;) {
+        unsigned serving =
+            atomic_load_explicit(&lock->now_serving, memory_order_acquire);
+        if (serving == ticket) break;
+        for (unsigned i = (ticket - serving) * LOCK_MIN_BACKOFF; i > 0; i--) {
+          Cpu_relax();
+        }
+        Spin_wait(&spins);
+      }
+      break;
+    }
+
+    case LOCK_MCS: {
+      atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+      atomic_store_explicit(&node->locked, 1, memory_order_relaxed);
+      lock_node_t* pred =
+          atomic_exchange_explicit(&lock->mcs_tail, node, memory_order_acq_rel);
+      if (pred != NULL) {
+        atomic_store_explicit(&pred->next, node, memory_order_release);
+        unsigned spins = 0;
+        while (atomic_load_explicit(&node->locked, memory_order_acquire)) {
+          Spin_wait(&spins);
+        }
+      }
+      break;
+    }
+
+    case LOCK_CLH: {
+      lock_cell_t* cell = node->cell;
+      atomic_store_explicit(&cell->locked, 1, memory_order_relaxed);
+      lock_cell_t* pred =
+          atomic_exchange_explicit(&lock->clh_tail, cell, memory_order_acq_rel);
+      unsigned spins = 0;
+      while (atomic_load_explicit(&pred->locked, memory_order_acquire)) {
+        Spin_wait(&spins);
+      }
+      node->pred = pred;
+      break;
+    }
+  }
+}
+
+/* Function:   lock_unlock
+ * In/out args: lock, node (the one passed to lock_lock)
+ */
+void lock_unlock(lock_t* lock, lock_node_t* node) {
+  switch (lock->kind) {
+    case LOCK_MUTEX:
+      pthread_mutex_unlock(&lock->mutex);
+      break;
+
+    case LOCK_TTAS:
+      atomic_store_explicit(&lock->flag, 0, memory_order_release);
+      break;
+
+    case LOCK_TICKET:
+      /* Only the holder writes now_serving */
+      atomic_store_explicit(
+          &lock->now_serving,
+          atomic_load_explicit(&lock->now_serving, memory_order_relaxed) + 1,
+          memory_order_release);
+      break;
+
+    case LOCK_MCS: {
+      lock_node_t* next =
+          atomic_load_explicit(&node->next, memory_order_acquire);
+      if (next == NULL) {
+        lock_node_t* expected = node;
+        if (atomic_compare_exchange_strong_explicit(
+                &lock->mcs_tail, &expected, NULL, memory_order_acq_rel,
+                memory_order_acquire)) {
+          break;
+        }
+        /* A successor swapped the tail but has not linked itself yet */
+        unsigned spins = 0;
+        while ((next = atomic_load_explicit(&node->next,
+                                            memory_order_acquire)) == NULL) {
+          Spin_wait(&spins);
+        }
+      }
+      atomic_store_explicit(&next->locked, 0, memory_order_release);
+      break;
+    }
+
+    case LOCK_CLH: {
+      lock_cell_t* cell = node->cell;
+      node->cell = node->pred;
+      atomic_store_explicit(&cell->locked, 0, memory_order_release);
+      break;
+    }
+  }
+}
+
+/* Function:      lock_node_init
+ * Out arg:       node
+ * Return value:  0 on success, -1 if allocation fails
+ */
+int lock_node_init(lock_node_t* node) {
+  atomic_init(&node->next, NULL);
+  atomic_init(&node->locked, 0);
+  node->pred = NULL;
+  node->cell = Cell_new(0);
+  return node->cell != NULL ? 0 : -1;
+}
+
+/* Function:   lock_node_destroy
+ * In/out arg: node, which must not hold a lock
+ */
+void lock_node_destroy(lock_node_t* node) {
+  free(node->cell);
+  node->cell = NULL;
+}
+
+/* Function:      lock_kind_parse
+ * In arg:        name ("mutex", "ttas", "ticket", "mcs" or "clh")
+ * Out arg:       kind_p
+ * Return value:  0 on success, -1 if the name is unknown
+ */
+int lock_kind_parse(const char* name, lock_kind_t* kind_p) {
+  for (int k = 0; k < (int)(sizeof(lock_names) / sizeof(lock_names[0])); k++) {
+    if (strcmp(name, lock_names[k]) == 0) {
+      *kind_p = (lock_kind_t)k;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+const char* lock_kind_name(lock_kind_t kind) { return lock_names[kind]; }
@@ -0,0 +1,187 @@
+/* File:     mc_integrate.c
+ *
+ * Purpose:  estimate the integral of a function over a d-dimensional box
+ *           with Monte Carlo (or quasi-Monte Carlo) sampling on pthreads
+ *
+ * mc_integrate:  integral, standard error and number of points used
+ *
+ * Notes:
+ * 1.  The points are split among the threads in contiguous blocks, with
+ *     the remainder spread over the first threads, as in monte_carlo_pi.c.
+ * 2.  Point i is always built from the same random numbers (Philox
+ *     doubles i*dim ... i*dim+dim-1, or Sobol point i), so the points do
+ *     not depend on the number of threads.
+ * 3.  Every thread accumulates into its own cache-line sized slot, and the
+ *     slots are combined by a tree of depth log2(thread_count): at level
+ *     k thread r adds in the slot of thread r + 2^k, with a barrier
+ *     between levels.
+ */
+#include "mc_integrate.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "philox.h"
+#include "sobol.h"
+
+#define MC_CACHE_LINE 64
+#define MC_POINTS_PER_BATCH 1024 /* Points per integrand call */
+
+/* Per-thread partial sums, one cache line each so that threads never
+ * write to the same line */
+typedef struct {
+  double sum;
+  double sum_sq;
+} __attribute__((aligned(MC_CACHE_LINE))) mc_accumulator_t;
+
+typedef struct {
+  const mc_problem_t* problem;
+  int thread_count;
+  long long points;
+  mc_accumulator_t* acc;
+  pthread_barrier_t barrier;
+} mc_shared_t;
+
+typedef struct {
+  mc_shared_t* shared;
+  long rank;
+} mc_thread_arg_t;
+
+static void* Integrate_work(void* arg);
+static void Tree_reduce(mc_shared_t* shared, long rank);
+
+/* Function:      mc_integrate
+ * In args:       problem, thread_count, points
+ * Out arg:       result
+ * Return value:  0 on success, -1 if the arguments are invalid
+ */
+int mc_integrate(const mc_problem_t* problem, int thread_count,
+                 long long points, mc_result_t* result) {
+  mc_shared_t shared;
+
+  if (problem->dim < 1 || thread_count < 1 || points < 1) return -1;
+  if (problem->sampler == MC_SOBOL &&
+      (problem->dim > SOBOL_MAX_DIM || points > (1LL << SOBOL_BITS))) {
+    return -1;
+  }
+
+  shared.problem = problem;
+  shared.thread_count = thread_count;
+  shared.points = points;
+  shared.acc = aligned_alloc(MC_CACHE_LINE,
+                             thread_count * sizeof(mc_accumulator_t));
+  pthread_barrier_init(&shared.barrier, NULL, thread_count);
+
+  pthread_t* thread_handles = malloc(thread_count * sizeof(pthread_t));
+  mc_thread_arg_t* args = malloc(thread_count * sizeof(mc_thread_arg_t));
+  for (long thread = 0; thread < thread_count; thread++) {
+    args[thread].shared = &shared;
+    args[thread].rank = thread;
+    pthread_create(&thread_handles[thread], NULL, Integrate_work,
+                   &args[thread]);
+  }
+  for (long thread = 0; thread < thread_count; thread++) {
+    pthread_join(thread_handles[thread], NULL);
+  }
+
+  double volume = 1.0;
+  for (int d = 0; d < problem->dim; d++) {
+    volume *= problem->upper[d] - problem->lower[d];
+  }
+  double mean = shared.acc[0].sum / points;
+  double variance = 0.0;
+  if (points > 1) {
+    variance = (shared.acc[0].sum_sq / points - mean * mean) * points /
+               (points - 1);
+    if (variance < 0) variance = 0;
+  }
+  result->estimate = volume * mean;
+  result->std_error = volume * sqrt(variance / points);
+  result->points = points;
+
+  pthread_barrier_destroy(&shared.barrier);
+  free(shared.acc);
+  free(thread_handles);
+  free(args);
+  return 0;
+}
+
+/* Function:   Integrate_work
+ * Purpose:    Evaluate the integrand on the thread's block of points,
+ *             MC_POINTS_PER_BATCH at a time, then join the reduction
+ */
+static void* Integrate_work(void* arg) {
+  mc_shared_t* shared = ((mc_thread_arg_t*)arg)->shared;
+  long rank = ((mc_thread_arg_t*)arg)->rank;
+  const mc_problem_t* problem = shared->problem;
+  int dim = problem->dim;
+  long long quotient = shared->points / shared->thread_count;
+  long long remainder = shared->points % shared->thread_count;
+  long long first, count;
+  double* x = malloc((size_t)MC_POINTS_PER_BATCH * dim * sizeof(double));
+  double values[MC_POINTS_PER_BATCH];
+  double sum = 0.0, sum_sq = 0.0;
+  sobol_t sobol;
+
+  if (rank < remainder) {
+    count = quotient + 1;
+    first = rank * count;
+  } else {
+    count = quotient;
+    first = rank * quotient + remainder;
+  }
+  if (problem->sampler == MC_SOBOL) sobol_init(&sobol, dim, first);
+
+  while (count > 0) {
+    int n = count < MC_POINTS_PER_BATCH ? (int)count : MC_POINTS_PER_BATCH;
+
+    if (problem->sampler == MC_SOBOL) {
+      sobol_fill(&sobol, x, n);
+    } else {
+      philox_fill_double(problem->seed, first * dim, x, (size_t)n * dim);
+    }
+    for (int i = 0; i < n; i++) {
+      for (int d = 0; d < dim; d++) {
+        x[i * dim + d] = problem->lower[d] +
+                         (problem->upper[d] - problem->lower[d]) * x[i * dim + d];
+      }
+    }
+
+    problem->f(x, dim, n, values, problem->arg);
+
+    /* Sum the batch first so that the running sums add similar sizes */
+    double batch_sum = 0.0, batch_sum_sq = 0.0;
+    for (int i = 0; i < n; i++) {
+      batch_sum += values[i];
+      batch_sum_sq += values[i] * values[i];
+    }
+    sum += batch_sum;
+    sum_sq += batch_sum_sq;
+
+    first += n;
+    count -= n;
+  }
+
+  shared->acc[rank].sum = sum;
+  shared->acc[rank].sum_sq = sum_sq;
+  Tree_reduce(shared, rank);
+
+  free(x);
+  return NULL;
+}
+
+/* Function:   Tree_reduce
+ * Purpose:    Combine the accumulators into acc[0] in log2(thread_count)
+ *             levels; the barrier before each level makes the partner's
+ *             slot complete before it is read
+ */
+static void Tree_reduce(mc_shared_t* shared, long rank) {
+  for (int stride = 1; stride < shared->thread_count; stride *= 2) {
+    pthread_barrier_wait(&shared->barrier);
+    if (rank % (2 * stride) == 0 && rank + stride < shared->thread_count) {
+      shared->acc[rank].sum += shared->acc[rank + stride].sum;
+      shared->acc[rank].sum_sq += shared->acc[rank + stride].sum_sq;
+    }
+  }
+}
@@ -2,8 +2,13 @@
  *
  * Purpose:  implement a linear congruential random number generator
  *
- * my_rand:  generates a random unsigned int in the range 0 - MR_MODULUS
- * my_drand: generates a random double in the range 0 - 1
+ * my_rand:        generates a random unsigned int in the range 0 - MR_MODULUS
+ * my_drand:       generates a random double in the range 0 - 1
+ * my_rand_jump:   advances a seed by k numbers in O(log k) steps
+ * my_rand_stream: start of the stream_id-th block of MR_STREAM_LENGTH
+ *                 numbers after base_seed
+ * my_rand_fill:   the next n numbers of the sequence, in bulk
+ * my_drand_fill:  the next n numbers as doubles in the range 0 - 1
  *
  * Notes:
  * 1.  The generator is taken from the Wikipedia article "Linear congruential
@@ -11,7 +16,12 @@
  * 2.  This is *not* a very good random number generator.  However, unlike
  *     the C library function random(), it *is* threadsafe:  the "state" of
  *     the generator is returned in the seed_p argument to each function.
- * 3.  The main function is just a simple driver.
+ * 3.  Since the increment is 0, seed_{n+k} = MR_MULTIPLIER^k * seed_n mod
+ *     MR_MODULUS.  The power is computed by repeated squaring, so a thread
+ *     that handles numbers first ... last of a serial run can jump
+ *     straight to number first and see exactly the numbers the serial
+ *     run would.
+ * 4.  The main function is just a simple driver.
  *
  * IPP:  Not discussed, but needed by the multithreaded linked list programs
  *       discussed in Section 4.9.2-4.9.4 (pp. 183-190).
@@ -26,6 +36,9 @@
 #define MR_MODULUS 4294967291U
 #define MR_DIVISOR ((double)4294967291U)
 
+/* Interleaved sequences advanced together by my_rand_fill */
+#define MR_FILL_LANES 8
+
 #ifdef _MAIN_
 int main(void) {
   int n, i;
@@ -44,6 +57,12 @@ int main(void) {
     y = my_drand(&x);
     printf("%e\n", y);
   }
+
+  /* The jump must land where n calls to my_rand do */
+  seed = 1;
+  x = my_rand_jump(seed, n);
+  for (i = 0; i < n; i++) my_rand(&seed);
+  printf("my_rand_jump: %u, my_rand: %u\n", x, seed);
   return 0;
 }
 #endif
@@ -77,3 +96,99 @@ double my_drand(unsigned* seed_p) {
   double y = x / MR_DIVISOR;
   return y;
 }
+
+/* Function:      Mod_mul
+ * Return value:  a * b mod MR_MODULUS
+ *
+ * Note:          MR_MODULUS = 2^32 - 5, so 2^32 = 5 (mod MR_MODULUS) and the
+ *                high word of the product can be folded into the low word
+ *                instead of dividing.
+ */
+static inline unsigned Mod_mul(unsigned a, unsigned b) {
+  unsigned long long z = (unsigned long long)a * b;
+  z = (z >> 32) * 5 + (z & 0xFFFFFFFFULL);
+  z = (z >> 32) * 5 + (z & 0xFFFFFFFFULL);
+  if (z >= MR_MODULUS) z -= MR_MODULUS;
+  return (unsigned)z;
+}
+
+/* Function:      Mod_pow
+ * Return value:  base^k mod MR_MODULUS, by repeated squaring
+ */
+static unsigned Mod_pow(unsigned base, unsigned long long k) {
+  unsigned result = 1;
+
+  /* MR_MODULUS is prime, so base^(MR_MODULUS - 1) = 1 */
+  k %= MR_MODULUS - 1;
+  while (k > 0) {
+    if (k & 1) result = Mod_mul(result, base);
+    base = Mod_mul(base, base);
+    k >>= 1;
+  }
+  return result;
+}
+
+/* Function:      my_rand_jump
+ * In args:       seed, k
+ * Return value:  The seed after k calls to my_rand, i.e. the k-th number
+ *                of the sequence that starts after seed
+ */
+unsigned my_rand_jump(unsigned seed, unsigned long long k) {
+  return Mod_mul(Mod_pow(MR_MULTIPLIER, k), seed);
+}
+
+/* Function:      my_rand_stream
+ * In args:       base_seed, stream_id
+ * Return value:  Seed for the stream_id-th block of MR_STREAM_LENGTH
+ *                numbers following base_seed.  Different streams of the
+ *                same base_seed do not overlap as long as no stream draws
+ *                more than MR_STREAM_LENGTH numbers.
+ */
+unsigned my_rand_stream(unsigned base_seed, unsigned stream_id) {
+  return my_rand_jump(base_seed, stream_id * MR_STREAM_LENGTH);
+}
+
+/* Function:      my_rand_fill
+ * In/out arg:    seed_p
+ * Out arg:       buf
+ * In arg:        n
+ * Purpose:       Store the next n numbers of the sequence in buf, the same
+ *                numbers n calls to my_rand would return, and advance the
+ *                seed past them.
+ *
+ * Note:          After the first MR_FILL_LANES numbers the buffer is
+ *                filled with a leapfrog: buf[i] = MULTIPLIER^MR_FILL_LANES
+ *                * buf[i - MR_FILL_LANES], which gives MR_FILL_LANES
+ *                independent chains instead of one serial dependence.
+ */
+void my_rand_fill(unsigned* seed_p, unsigned* buf, size_t n) {
+  unsigned x = *seed_p;
+  unsigned leap = Mod_pow(MR_MULTIPLIER, MR_FILL_LANES);
+  size_t i;
+
+  if (n == 0) return;
+  for (i = 0; i < n && i < MR_FILL_LANES; i++) {
+    x = Mod_mul(x, MR_MULTIPLIER);
+    buf[i] = x;
+  }
+  for (; i < n; i++) buf[i] = Mod_mul(buf[i - MR_FILL_LANES], leap);
+  *seed_p = buf[n - 1];
+}
+
+/* Function:      my_drand_fill
+ * In/out arg:    seed_p
+ * Out arg:       buf
+ * In arg:        n
+ * Purpose:       Store the next n doubles my_drand would return in buf
+ */
+void my_drand_fill(unsigned* seed_p, double* buf, size_t n) {
+  unsigned block[1024];
+
+  while (n > 0) {
+    size_t count = n < 1024 ? n : 1024;
+    my_rand_fill(seed_p, block, count);
+    for (size_t i = 0; i < count; i++) buf[i] = block[i] / MR_DIVISOR;
+    buf += count;
+    n -= count;
+  }
+}
@@ -0,0 +1,152 @@
+/* File:     my_rwlock.c
+ *
+ * Purpose:  implement a reader-writer lock with read or write priority
+ *           from a mutex and two condition variables
+ *
+ * Notes:
+ * 1.  Every lock and unlock, reader or writer, takes the internal mutex,
+ *     so readers never block each other for long but all of them touch
+ *     the same cache lines.  See bravo_rwlock.c for a reader fast path.
+ * 2.  With -DINSTRUMENT, wait times run from the call to the moment the
+ *     thread owns the lock, so they include waiting for the internal
+ *     mutex; hold times run from then to the call of my_rwlock_unlock.
+ */
+#include "my_rwlock.h"
+
+#ifdef INSTRUMENT
+/* When the calling thread got the lock it holds */
+static _Thread_local unsigned long long acquired_ns;
+
+/* Samples the queues seen by a thread arriving at lock */
+static void Record_queues(my_rwlock_t* lock) {
+  lh_record(&lock->stats.readers_queued, lock->waiting_readers);
+  lh_record(&lock->stats.writers_queued, lock->waiting_writers);
+}
+#endif
+
+/* Initialize the custom read-write lock */
+void my_rwlock_init(my_rwlock_t* lock, int priority_mode) {
+  pthread_mutex_init(&lock->mutex, NULL);
+  pthread_cond_init(&lock->readers_cond, NULL);
+  pthread_cond_init(&lock->writers_cond, NULL);
+  lock->active_readers = 0;
+  lock->waiting_readers = 0;
+  lock->active_writers = 0;
+  lock->waiting_writers = 0;
+  lock->priority = priority_mode;
+#ifdef INSTRUMENT
+  lh_init(&lock->stats.read_wait);
+  lh_init(&lock->stats.write_wait);
+  lh_init(&lock->stats.read_hold);
+  lh_init(&lock->stats.write_hold);
+  lh_init(&lock->stats.readers_queued);
+  lh_init(&lock->stats.writers_queued);
+#endif
+}
+
+/* Destroy the custom read-write lock */
+void my_rwlock_destroy(my_rwlock_t* lock) {
+  pthread_mutex_destroy(&lock->mutex);
+  pthread_cond_destroy(&lock->readers_cond);
+  pthread_cond_destroy(&lock->writers_cond);
+}
+
+/* Acquire the lock for reading */
+void my_rwlock_rdlock(my_rwlock_t* lock) {
+#ifdef INSTRUMENT
+  unsigned long long start_ns = lh_now_ns();
+#endif
+  pthread_mutex_lock(&lock->mutex);
+#ifdef INSTRUMENT
+  Record_queues(lock);
+#endif
+  if (lock->priority == READ_PRIORITY) {
+    /* Read-priority: Readers proceed if no active writers */
+    while (lock->active_writers > 0) {
+      lock->waiting_readers++;
+      pthread_cond_wait(&lock->readers_cond, &lock->mutex);
+      lock->waiting_readers--;
+    }
+  } else {
+    /* Write-priority: Readers wait if there are active or waiting writers */
+    while (lock->active_writers > 0 || lock->waiting_writers > 0) {
+      lock->waiting_readers++;
+      pthread_cond_wait(&lock->readers_cond, &lock->mutex);
+      lock->waiting_readers--;
+    }
+  }
+  lock->active_readers++;
+#ifdef INSTRUMENT
+  acquired_ns = lh_now_ns();
+  lh_record(&lock->stats.read_wait, acquired_ns - start_ns);
+#endif
+  pthread_mutex_unlock(&lock->mutex);
+}
+
+/* Acquire the lock for writing */
+void my_rwlock_wrlock(my_rwlock_t* lock) {
+#ifdef INSTRUMENT
+  unsigned long long start_ns = lh_now_ns();
+#endif
+  pthread_mutex_lock(&lock->mutex);
+#ifdef INSTRUMENT
+  Record_queues(lock);
+#endif
+  lock->waiting_writers++;
+  while (lock->active_writers > 0 || lock->active_readers > 0) {
+    pthread_cond_wait(&lock->writers_cond, &lock->mutex);
+  }
+  lock->waiting_writers--;
+  lock->active_writers++;
+#ifdef INSTRUMENT
+  acquired_ns = lh_now_ns();
+  lh_record(&lock->stats.write_wait, acquired_ns - start_ns);
+#endif
+  pthread_mutex_unlock(&lock->mutex);
+}
+
+/* Release the lock */
+void my_rwlock_unlock(my_rwlock_t* lock) {
+#ifdef INSTRUMENT
+  unsigned long long held_ns = lh_now_ns() - acquired_ns;
+#endif
+  pthread_mutex_lock(&lock->mutex);
+  if (lock->active_writers > 0) {
+    /* Unlocking a writer */
+    lock->active_writers--;
+#ifdef INSTRUMENT
+    lh_record(&lock->stats.write_hold, held_ns);
+#endif
+  } else {
+    /* Unlocking a reader */
+    lock->active_readers--;
+#ifdef INSTRUMENT
+    lh_record(&lock->stats.read_hold, held_ns);
+#endif
+  }
+
+  if (lock->active_writers == 0) {
+    if (lock->priority == WRITE_PRIORITY && lock->waiting_writers > 0) {
+      /* Give priority to writers */
+      pthread_cond_signal(&lock->writers_cond);
+    } else if (lock->waiting_readers > 0) {
+      /* Wake up all waiting readers */
+      pthread_cond_broadcast(&lock->readers_cond);
+    } else if (lock->waiting_writers > 0) {
+      /* Wake up one waiting writer */
+      pthread_cond_signal(&lock->writers_cond);
+    }
+  }
+  pthread_mutex_unlock(&lock->mutex);
+}
+
+#ifdef INSTRUMENT
+void my_rwlock_print_stats(const my_rwlock_t* lock, FILE* stream) {
+  lh_print(&lock->stats.read_wait, "read wait (ns)", stream);
+  lh_print(&lock->stats.read_hold, "read hold (ns)", stream);
+  lh_print(&lock->stats.write_wait, "write wait (ns)", stream);
+  lh_print(&lock->stats.write_hold, "write hold (ns)", stream);
+  lh_print(&lock->stats.readers_queued, "readers queued on arrival", stream);
+  lh_print(&lock->stats.writers_queued, "writers queued on arrival", stream);
+}
+#endif
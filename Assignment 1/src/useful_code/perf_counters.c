@@ -0,0 +1,159 @@
+/* File:     perf_counters.c
+ *
+ * Purpose:  count hardware events of the process with perf_event_open
+ *
+ * pc_open, pc_close:  open / close one counter per event
+ * pc_start, pc_stop:  reset and enable / disable and read the counters,
+ *                     scaling multiplexed ones
+ * pc_print:           print the counts, in total and per operation
+ *
+ * Notes:
+ * 1.  HITM (a load served from a line modified in another core's cache)
+ *     is the signature of true and false sharing, but has no generic perf
+ *     event.  The default raw event is MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM
+ *     (event 0xd2, umask 0x04) of Intel Skylake and later; set
+ *     PERF_HITM_EVENT to the raw config of another CPU, e.g.
+ *     PERF_HITM_EVENT=0x04d2.
+ * 2.  glibc has no wrapper for perf_event_open, so it is called through
+ *     syscall.
+ * 3.  Each read also returns the total time the event was enabled and
+ *     running.  A reset only clears the count, so pc_start keeps the
+ *     times and pc_stop takes the difference.
+ */
+#include "perf_counters.h"
+
+#include <linux/perf_event.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PC_DEFAULT_HITM 0x04d2ULL
+
+/* What read returns with PC_READ_FORMAT */
+typedef struct {
+  unsigned long long value, enabled, running;
+} pc_reading_t;
+
+#define PC_READ_FORMAT \
+  (PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING)
+
+static const char* pc_names[PC_EVENT_COUNT] = {
+    "cycles", "instructions", "cache-misses", "L1d-read-misses", "HITM"};
+
+static int Open_event(unsigned type, unsigned long long config) {
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PC_READ_FORMAT;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/* Function:   pc_open
+ * Out arg:    pc
+ * Purpose:    Open a disabled counter for each event; unavailable events
+ *             get fd -1
+ */
+void pc_open(perf_counters_t* pc) {
+  unsigned long long hitm = PC_DEFAULT_HITM;
+  const char* env = getenv("PERF_HITM_EVENT");
+  if (env != NULL) hitm = strtoull(env, NULL, 0);
+
+  pc->fd[PC_CYCLES] = Open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  pc->fd[PC_INSTRUCTIONS] =
+      Open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  pc->fd[PC_CACHE_MISSES] =
+      Open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+  pc->fd[PC_L1D_MISSES] = Open_event(
+      PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  pc->fd[PC_HITM] = Open_event(PERF_TYPE_RAW, hitm);
+  memset(pc->value, 0, sizeof(pc->value));
+  memset(pc->enabled, 0, sizeof(pc->enabled));
+  memset(pc->running, 0, sizeof(pc->running));
+}
+
+/* Reads counter e; on failure closes it, so it is reported as n/a */
+static int Read_event(perf_counters_t* pc, int e, pc_reading_t* reading) {
+  if (read(pc->fd[e], reading, sizeof(*reading)) == sizeof(*reading)) {
+    return 0;
+  }
+  close(pc->fd[e]);
+  pc->fd[e] = -1;
+  return -1;
+}
+
+void pc_start(perf_counters_t* pc) {
+  pc_reading_t reading;
+
+  for (int e = 0; e < PC_EVENT_COUNT; e++) {
+    if (pc->fd[e] < 0) continue;
+    ioctl(pc->fd[e], PERF_EVENT_IOC_RESET, 0);
+    if (Read_event(pc, e, &reading) != 0) continue;
+    pc->enabled[e] = reading.enabled;
+    pc->running[e] = reading.running;
+    ioctl(pc->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+/* Function:   pc_stop
+ * In/out arg: pc
+ * Purpose:    Disable the counters and read them, scaling the count of a
+ *             multiplexed event by enabled / running time; a counter that
+ *             cannot be read is closed and reported as n/a
+ */
+void pc_stop(perf_counters_t* pc) {
+  pc_reading_t reading;
+
+  for (int e = 0; e < PC_EVENT_COUNT; e++) {
+    if (pc->fd[e] < 0) continue;
+    ioctl(pc->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    if (Read_event(pc, e, &reading) != 0) continue;
+    pc->enabled[e] = reading.enabled - pc->enabled[e];
+    pc->running[e] = reading.running - pc->running[e];
+    pc->value[e] = reading.value;
+    if (pc->running[e] > 0 && pc->running[e] < pc->enabled[e]) {
+      pc->value[e] =
+          (unsigned long long)((double)reading.value * pc->enabled[e] /
+                               pc->running[e]);
+    }
+  }
+}
+
+void pc_close(perf_counters_t* pc) {
+  for (int e = 0; e < PC_EVENT_COUNT; e++) {
+    if (pc->fd[e] >= 0) close(pc->fd[e]);
+    pc->fd[e] = -1;
+  }
+}
+
+/* Function:   pc_print
+ * In args:    pc, ops (number of operations the counts are divided by)
+ * Out arg:    out
+ */
+void pc_print(const perf_counters_t* pc, unsigned long long ops, FILE* out) {
+  for (int e = 0; e < PC_EVENT_COUNT; e++) {
+    if (pc->fd[e] < 0) {
+      fprintf(out, "%-16s n/a\n", pc_names[e]);
+    } else if (pc->running[e] == 0 && pc->enabled[e] > 0) {
+      fprintf(out, "%-16s n/a (never scheduled on a counter)\n", pc_names[e]);
+    } else {
+      fprintf(out, "%-16s %llu (%.4f per op)", pc_names[e], pc->value[e],
+              (double)pc->value[e] / ops);
+      if (pc->running[e] < pc->enabled[e]) {
+        fprintf(out, ", multiplexed: scaled from %.1f%% of the run",
+                100.0 * pc->running[e] / pc->enabled[e]);
+      }
+      fprintf(out, "\n");
+    }
+  }
+}
@@ -0,0 +1,267 @@
+/* File:     philox.c
+ *
+ * Purpose:  implement the Philox4x32-10 counter-based random number
+ *           generator (Salmon et al., "Parallel Random Numbers: As Easy
+ *           as 1, 2, 3", SC'11)
+ *
+ * philox4x32:         one 4x32 block for a single counter
+ * philox_fill_u32:    words first ... first+n-1 of the stream for seed
+ * philox_fill_float:  uniform floats in [0, 1) (24 bits each)
+ * philox_fill_double: uniform doubles in [0, 1) (53 bits, two words each)
+ *
+ * Notes:
+ * 1.  Word p of the stream is word (p / PHILOX_BATCH) % 4 of counter
+ *     (p / PHILOX_BATCH_WORDS) * PHILOX_BATCH + p % PHILOX_BATCH.  This
+ *     lane-major layout lets a whole batch be stored with contiguous
+ *     vector stores.
+ * 2.  Philox_batch uses AVX-512 or AVX2 intrinsics when the compiler
+ *     targets them (-march=native) and plain C otherwise; all versions
+ *     produce the same stream.
+ * 3.  The 64-bit seed is the Philox key; the counter is the batch lane
+ *     index, so two different seeds give independent streams.
+ * 4.  The main function is just a known-answer test, compile with -D_MAIN_.
+ */
+#include "philox.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+#define PHILOX_ROUNDS 10
+
+#define PHILOX_FLOAT_SCALE (1.0f / 16777216.0f)        /* 2^-24 */
+#define PHILOX_DOUBLE_SCALE (1.0 / 9007199254740992.0) /* 2^-53 */
+
+/* Words converted per pass of the float/double fill routines */
+#define PHILOX_CHUNK (16 * PHILOX_BATCH_WORDS)
+
+#ifdef _MAIN_
+int main(void) {
+  /* Known-answer test from the Random123 distribution */
+  uint32_t zero[4] = {0, 0, 0, 0}, out[4];
+  uint32_t batch[PHILOX_BATCH_WORDS];
+
+  philox4x32(zero, 0, out);
+  printf("%08x %08x %08x %08x (expect 6627e8d5 e169c58d bc57ac4c 9b00dbd8)\n",
+         out[0], out[1], out[2], out[3]);
+
+  philox_fill_u32(0, 0, batch, PHILOX_BATCH_WORDS);
+  printf("%08x %08x %08x %08x (batched)\n", batch[0], batch[PHILOX_BATCH],
+         batch[2 * PHILOX_BATCH], batch[3 * PHILOX_BATCH]);
+  return 0;
+}
+#endif
+
+/* Function:   philox4x32
+ * In args:    ctr, seed
+ * Out arg:    out
+ * Purpose:    Compute the ten-round Philox block for a single counter
+ */
+void philox4x32(const uint32_t ctr[4], uint64_t seed, uint32_t out[4]) {
+  uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+  uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+
+  for (int r = 0; r < PHILOX_ROUNDS; r++) {
+    uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+    uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+    c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    c1 = (uint32_t)p1;
+    c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c3 = (uint32_t)p0;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX512F__)
+#define PHILOX_VEC_LANES 16
+typedef __m512i philox_vec_t;
+#define VEC_SET1(x) _mm512_set1_epi32((int)(x))
+#define VEC_LOAD(p) _mm512_loadu_si512((const void*)(p))
+#define VEC_STORE(p, v) _mm512_storeu_si512((void*)(p), v)
+#define VEC_XOR(a, b) _mm512_xor_si512(a, b)
+
+/* 32x32->64-bit products of all 16 lanes: the even lanes directly, the
+ * odd lanes after shifting them down; one two-source permute then gathers
+ * the high halves and another the low halves back into lane order */
+static inline void Mulhilo(philox_vec_t a, philox_vec_t m, philox_vec_t* hi,
+                           philox_vec_t* lo) {
+  const philox_vec_t hi_idx = _mm512_setr_epi32(
+      1, 17, 3, 19, 5, 21, 7, 23, 9, 25, 11, 27, 13, 29, 15, 31);
+  const philox_vec_t lo_idx = _mm512_setr_epi32(
+      0, 16, 2, 18, 4, 20, 6, 22, 8, 24, 10, 26, 12, 28, 14, 30);
+  philox_vec_t even = _mm512_mul_epu32(a, m);
+  philox_vec_t odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), m);
+  *hi = _mm512_permutex2var_epi32(even, hi_idx, odd);
+  *lo = _mm512_permutex2var_epi32(even, lo_idx, odd);
+}
+#elif defined(__AVX2__)
+#define PHILOX_VEC_LANES 8
+typedef __m256i philox_vec_t;
+#define VEC_SET1(x) _mm256_set1_epi32((int)(x))
+#define VEC_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define VEC_STORE(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+#define VEC_XOR(a, b) _mm256_xor_si256(a, b)
+
+static inline void Mulhilo(philox_vec_t a, philox_vec_t m, philox_vec_t* hi,
+                           philox_vec_t* lo) {
+  philox_vec_t even = _mm256_mul_epu32(a, m);
+  philox_vec_t odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+  *lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+  *hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+#endif
+
+#ifdef PHILOX_VEC_LANES
+#define PHILOX_VECS (PHILOX_BATCH / PHILOX_VEC_LANES)
+
+/* Function:   Philox_batch
+ * In args:    seed, batch
+ * Out arg:    out (PHILOX_BATCH_WORDS words, lane-major)
+ * Purpose:    Run PHILOX_BATCH counters through the rounds at once.
+ *             Several registers per word keep independent multiplies in
+ *             flight, so the rounds are not latency bound.
+ */
+static void Philox_batch(uint64_t seed, uint64_t batch, uint32_t* out) {
+  philox_vec_t c0[PHILOX_VECS], c1[PHILOX_VECS], c2[PHILOX_VECS],
+      c3[PHILOX_VECS];
+  philox_vec_t m0 = VEC_SET1(PHILOX_M0), m1 = VEC_SET1(PHILOX_M1);
+  uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+  uint32_t lo[PHILOX_BATCH], hi[PHILOX_BATCH];
+  uint64_t ctr = batch * PHILOX_BATCH;
+
+  for (int j = 0; j < PHILOX_BATCH; j++) {
+    lo[j] = (uint32_t)(ctr + j);
+    hi[j] = (uint32_t)((ctr + j) >> 32);
+  }
+  for (int v = 0; v < PHILOX_VECS; v++) {
+    c0[v] = VEC_LOAD(lo + v * PHILOX_VEC_LANES);
+    c1[v] = VEC_LOAD(hi + v * PHILOX_VEC_LANES);
+    c2[v] = VEC_SET1(0);
+    c3[v] = VEC_SET1(0);
+  }
+
+  for (int r = 0; r < PHILOX_ROUNDS; r++) {
+    philox_vec_t key0 = VEC_SET1(k0), key1 = VEC_SET1(k1);
+    for (int v = 0; v < PHILOX_VECS; v++) {
+      philox_vec_t hi0, lo0, hi1, lo1;
+      Mulhilo(c0[v], m0, &hi0, &lo0);
+      Mulhilo(c2[v], m1, &hi1, &lo1);
+      c0[v] = VEC_XOR(VEC_XOR(hi1, c1[v]), key0);
+      c1[v] = lo1;
+      c2[v] = VEC_XOR(VEC_XOR(hi0, c3[v]), key1);
+      c3[v] = lo0;
+    }
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+
+  for (int v = 0; v < PHILOX_VECS; v++) {
+    VEC_STORE(out + v * PHILOX_VEC_LANES, c0[v]);
+    VEC_STORE(out + PHILOX_BATCH + v * PHILOX_VEC_LANES, c1[v]);
+    VEC_STORE(out + 2 * PHILOX_BATCH + v * PHILOX_VEC_LANES, c2[v]);
+    VEC_STORE(out + 3 * PHILOX_BATCH + v * PHILOX_VEC_LANES, c3[v]);
+  }
+}
+#else
+/* Function:   Philox_batch
+ * In args:    seed, batch
+ * Out arg:    out (PHILOX_BATCH_WORDS words, lane-major)
+ * Purpose:    Portable version: the same lanes one counter at a time
+ */
+static void Philox_batch(uint64_t seed, uint64_t batch, uint32_t* out) {
+  uint64_t ctr = batch * PHILOX_BATCH;
+
+  for (int j = 0; j < PHILOX_BATCH; j++) {
+    uint32_t in[4] = {(uint32_t)(ctr + j), (uint32_t)((ctr + j) >> 32), 0, 0};
+    uint32_t block[4];
+    philox4x32(in, seed, block);
+    for (int w = 0; w < 4; w++) out[w * PHILOX_BATCH + j] = block[w];
+  }
+}
+#endif
+
+/* Function:   philox_fill_u32
+ * In args:    seed, first, n
+ * Out arg:    buf
+ * Purpose:    Store words first ... first+n-1 of the stream in buf.
+ *             Whole batches go straight into buf; a partial batch at
+ *             either end is generated into a scratch block and copied.
+ */
+void philox_fill_u32(uint64_t seed, uint64_t first, uint32_t* buf, size_t n) {
+  uint32_t scratch[PHILOX_BATCH_WORDS];
+
+  while (n > 0) {
+    uint64_t batch = first / PHILOX_BATCH_WORDS;
+    size_t offset = first % PHILOX_BATCH_WORDS;
+    size_t count = PHILOX_BATCH_WORDS - offset;
+
+    if (count > n) count = n;
+    if (count == PHILOX_BATCH_WORDS) {
+      Philox_batch(seed, batch, buf);
+    } else {
+      Philox_batch(seed, batch, scratch);
+      memcpy(buf, scratch + offset, count * sizeof(uint32_t));
+    }
+    buf += count;
+    first += count;
+    n -= count;
+  }
+}
+
+/* Function:   philox_fill_float
+ * In args:    seed, first, n
+ * Out arg:    buf
+ * Purpose:    Uniform floats in [0, 1); float p comes from word p
+ */
+void philox_fill_float(uint64_t seed, uint64_t first, float* buf, size_t n) {
+  uint32_t words[PHILOX_CHUNK];
+
+  while (n > 0) {
+    size_t count = n < PHILOX_CHUNK ? n : PHILOX_CHUNK;
+
+    philox_fill_u32(seed, first, words, count);
+    for (size_t i = 0; i < count; i++) {
+      buf[i] = (float)(int32_t)(words[i] >> 8) * PHILOX_FLOAT_SCALE;
+    }
+    buf += count;
+    first += count;
+    n -= count;
+  }
+}
+
+/* Function:   philox_fill_double
+ * In args:    seed, first, n
+ * Out arg:    buf
+ * Purpose:    Uniform doubles in [0, 1); double p comes from words 2p
+ *             and 2p+1
+ */
+void philox_fill_double(uint64_t seed, uint64_t first, double* buf,
+                        size_t n) {
+  uint32_t words[PHILOX_CHUNK];
+
+  while (n > 0) {
+    size_t count = n < PHILOX_CHUNK / 2 ? n : PHILOX_CHUNK / 2;
+
+    philox_fill_u32(seed, 2 * first, words, 2 * count);
+    for (size_t i = 0; i < count; i++) {
+      uint64_t bits =
+          ((uint64_t)(words[2 * i] >> 5) << 26) | (words[2 * i + 1] >> 6);
+      buf[i] = (double)(int64_t)bits * PHILOX_DOUBLE_SCALE;
+    }
+    buf += count;
+    first += count;
+    n -= count;
+  }
+}
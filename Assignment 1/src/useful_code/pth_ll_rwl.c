@@ -35,6 +35,10 @@
 /* Random ints are less than MAX_KEY */
 const int MAX_KEY = 100000000;
 
+/* The keys inserted by main come from stream 0 of the random sequence
+ * starting at BASE_SEED, the ops of the threads from stream 1 */
+const unsigned BASE_SEED = 1;
+
 /* Struct for list nodes */
 struct list_node_s {
   int data;
@@ -73,7 +77,7 @@ int main(int argc, char* argv[]) {
   int key, success, attempts;
   pthread_t* thread_handles;
   int inserts_in_main;
-  unsigned seed = 1;
+  unsigned seed = my_rand_stream(BASE_SEED, 0);
   double start, finish;
 
   if (argc != 2) Usage(argv[0]);
@@ -280,9 +284,22 @@ void* Thread_work(void* rank) {
   long my_rank = (long)rank;
   int i, val;
   double which_op;
-  unsigned seed = my_rank + 1;
+  unsigned seed;
   int my_member_count = 0, my_insert_count = 0, my_delete_count = 0;
   int ops_per_thread = total_ops / thread_count;
+  int remainder = total_ops % thread_count;
+  long long my_first_op;
+
+  /* Each thread runs a contiguous block of the serial op sequence and
+   * jumps to its start: every op draws two numbers, so the ops are the
+   * same for any thread count */
+  if (my_rank < remainder) {
+    ops_per_thread++;
+    my_first_op = my_rank * ops_per_thread;
+  } else {
+    my_first_op = my_rank * ops_per_thread + remainder;
+  }
+  seed = my_rand_jump(my_rand_stream(BASE_SEED, 1), 2 * my_first_op);
 
   for (i = 0; i < ops_per_thread; i++) {
     which_op = my_drand(&seed);
@@ -0,0 +1,120 @@
+/* File:     qsbr.c
+ *
+ * Purpose:  implement quiescent-state-based reclamation (McKenney and
+ *           Slingwine, "Read-copy update", 1998; Hart et al., 2007)
+ *
+ * qsbr_init, qsbr_destroy:  set up / tear down, freeing all retired items
+ * qsbr_quiescent:           thread rank holds no pointer into the structure
+ * qsbr_retire:              free item after the next grace period
+ *
+ * Notes:
+ * 1.  Retiring an item increments the global counter to a new value c,
+ *     and the item is tagged with c.  A thread that later reports a
+ *     quiescent state with a counter value >= c read the counter after the
+ *     unlink, so its later operations cannot reach the item, and its
+ *     earlier ones have finished.  Once every thread has reported >= c
+ *     the item is freed.
+ * 2.  A quiescent state costs one load of the counter and one store to
+ *     the thread's own cache line.  Only writers scan the slots, every
+ *     QSBR_RECLAIM_INTERVAL retirements.
+ * 3.  Writers never wait for a grace period.  A thread that stops
+ *     reporting quiescent states (blocked, or finished) holds back
+ *     reclamation until it reports again or the structure is destroyed.
+ */
+#include "qsbr.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define QSBR_RECLAIM_INTERVAL 64
+
+/* Frees the items of slot whose grace period has passed */
+static void Reclaim(qsbr_t* qsbr, qsbr_slot_t* slot) {
+  unsigned long oldest = atomic_load(&qsbr->counter);
+  size_t done = 0;
+
+  for (int r = 0; r < qsbr->thread_count; r++) {
+    unsigned long seen =
+        atomic_load_explicit(&qsbr->slots[r].seen, memory_order_acquire);
+    if (seen < oldest) oldest = seen;
+  }
+  while (done < slot->count && slot->tags[done] <= oldest) {
+    qsbr->free_fn(slot->items[done++]);
+  }
+  slot->count -= done;
+  memmove(slot->items, slot->items + done, slot->count * sizeof(void*));
+  memmove(slot->tags, slot->tags + done, slot->count * sizeof(unsigned long));
+}
+
+/* Function:      qsbr_init
+ * In args:       thread_count, free_fn (frees one retired item)
+ * Out arg:       qsbr
+ * Return value:  0 on success, -1 if allocation fails
+ */
+int qsbr_init(qsbr_t* qsbr, int thread_count, void (*free_fn)(void*)) {
+  qsbr->slots =
+      aligned_alloc(QSBR_CACHE_LINE, thread_count * sizeof(qsbr_slot_t));
+  if (qsbr->slots == NULL) return -1;
+  atomic_init(&qsbr->counter, 1);
+  qsbr->thread_count = thread_count;
+  qsbr->free_fn = free_fn;
+  for (int r = 0; r < thread_count; r++) {
+    qsbr_slot_t* slot = &qsbr->slots[r];
+    atomic_init(&slot->seen, 1);
+    slot->items = NULL;
+    slot->tags = NULL;
+    slot->count = slot->capacity = 0;
+    slot->retired_since_reclaim = 0;
+  }
+  return 0;
+}
+
+/* Function:   qsbr_destroy
+ * In/out arg: qsbr, with no thread using the structure
+ */
+void qsbr_destroy(qsbr_t* qsbr) {
+  for (int r = 0; r < qsbr->thread_count; r++) {
+    qsbr_slot_t* slot = &qsbr->slots[r];
+    for (size_t i = 0; i < slot->count; i++) qsbr->free_fn(slot->items[i]);
+    free(slot->items);
+    free(slot->tags);
+  }
+  free(qsbr->slots);
+  qsbr->slots = NULL;
+}
+
+void qsbr_quiescent(qsbr_t* qsbr, long rank) {
+  unsigned long now =
+      atomic_load_explicit(&qsbr->counter, memory_order_acquire);
+
+  /* Release: the thread's earlier reads of the structure happen before a
+   * writer that sees the new value frees anything */
+  atomic_store_explicit(&qsbr->slots[rank].seen, now, memory_order_release);
+}
+
+/* Function:   qsbr_retire
+ * In args:    rank, item (already unlinked)
+ * In/out arg: qsbr
+ */
+void qsbr_retire(qsbr_t* qsbr, long rank, void* item) {
+  qsbr_slot_t* slot = &qsbr->slots[rank];
+  unsigned long tag = atomic_fetch_add(&qsbr->counter, 1) + 1;
+
+  if (slot->count == slot->capacity) {
+    size_t capacity = slot->capacity ? 2 * slot->capacity : 64;
+    void** items = realloc(slot->items, capacity * sizeof(void*));
+    if (items == NULL) return; /* Leak rather than free too early */
+    slot->items = items;
+    unsigned long* tags = realloc(slot->tags, capacity * sizeof(unsigned long));
+    if (tags == NULL) return;
+    slot->tags = tags;
+    slot->capacity = capacity;
+  }
+  slot->items[slot->count] = item;
+  slot->tags[slot->count++] = tag;
+
+  if (++slot->retired_since_reclaim >= QSBR_RECLAIM_INTERVAL) {
+    slot->retired_since_reclaim = 0;
+    Reclaim(qsbr, slot);
+  }
+}
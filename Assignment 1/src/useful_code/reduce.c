@@ -0,0 +1,268 @@
+/* File:     reduce.c
+ *
+ * Purpose:  implement the reductions of reduce.h
+ *
+ * reduce_local:     reduce an array in the calling thread
+ * reducer_init, reducer_destroy:  set up / free a team reducer
+ * reducer_combine:  called by every thread of the team with its value,
+ *                   returns the reduction of all values to every thread
+ * reduce_parallel:  reduce an array with a team of new threads
+ *
+ * Notes:
+ * 1.  The built-in operators keep REDUCE_VECTORS vector accumulators of
+ *     REDUCE_WIDTH doubles (GCC vector extensions, mapped onto AVX or
+ *     SSE2 registers).  The independent accumulators also break the
+ *     dependency chain between iterations, so the loop is limited by
+ *     memory bandwidth instead of by the latency of the add.
+ *     Floating-point sums therefore add in a different order from a
+ *     serial loop.  Min and max select with a compare mask, as (a < b ?
+ *     a : b) is not vectorized without -ffast-math.
+ * 2.  The tree is the one of mc_integrate.c: at level k position p adds
+ *     in position p + 2^k, with a barrier before each level.  In
+ *     NUMA-aware mode rank 0 sorts the ranks by the node every thread
+ *     reported on arrival (threads may migrate, so this is redone on
+ *     every call).
+ * 3.  The result goes to a field of its own rather than a slot, so a fast
+ *     thread can enter the next call and overwrite its slot while slower
+ *     threads are still reading the result.
+ */
+#define _GNU_SOURCE
+#include "reduce.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Doubles per vector: a whole AVX register if the target has one */
+#ifdef __AVX__
+#define REDUCE_WIDTH 4
+#else
+#define REDUCE_WIDTH 2
+#endif
+#define REDUCE_VECTORS 4 /* Vector accumulators */
+#define REDUCE_LANES (REDUCE_WIDTH * REDUCE_VECTORS)
+
+typedef double vec_t __attribute__((vector_size(REDUCE_WIDTH * 8)));
+typedef long long mask_t __attribute__((vector_size(REDUCE_WIDTH * 8)));
+
+static inline vec_t Load(const double* p) {
+  vec_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/* Lanewise mask ? a : b, where mask lanes are all ones or all zeros */
+static inline vec_t Select(mask_t mask, vec_t a, vec_t b) {
+  return (vec_t)((mask & (mask_t)a) | (~mask & (mask_t)b));
+}
+
+static double Sum(double a, double b) { return a + b; }
+static double Min(double a, double b) { return b < a ? b : a; }
+static double Max(double a, double b) { return b > a ? b : a; }
+
+const reduce_op_t REDUCE_SUM = {Sum, 0.0};
+const reduce_op_t REDUCE_MIN = {Min, __builtin_inf()};
+const reduce_op_t REDUCE_MAX = {Max, -__builtin_inf()};
+
+typedef struct {
+  const double* a;
+  size_t n;
+  int thread_count;
+  reducer_t* reducer;
+  long rank;
+  double result;
+} reduce_arg_t;
+
+/* Function:      reduce_local
+ * In args:       a, n, op
+ * Return value:  op applied over a[0 ... n-1], op->identity if n == 0
+ */
+double reduce_local(const double* a, size_t n, const reduce_op_t* op) {
+  vec_t acc[REDUCE_VECTORS];
+  size_t i = 0;
+
+  for (int v = 0; v < REDUCE_VECTORS; v++) {
+    for (int j = 0; j < REDUCE_WIDTH; j++) acc[v][j] = op->identity;
+  }
+
+  if (op == &REDUCE_SUM) {
+    for (; i + REDUCE_LANES <= n; i += REDUCE_LANES) {
+      for (int v = 0; v < REDUCE_VECTORS; v++) {
+        acc[v] += Load(a + i + v * REDUCE_WIDTH);
+      }
+    }
+  } else if (op == &REDUCE_MIN) {
+    for (; i + REDUCE_LANES <= n; i += REDUCE_LANES) {
+      for (int v = 0; v < REDUCE_VECTORS; v++) {
+        vec_t x = Load(a + i + v * REDUCE_WIDTH);
+        acc[v] = Select(x < acc[v], x, acc[v]);
+      }
+    }
+  } else if (op == &REDUCE_MAX) {
+    for (; i + REDUCE_LANES <= n; i += REDUCE_LANES) {
+      for (int v = 0; v < REDUCE_VECTORS; v++) {
+        vec_t x = Load(a + i + v * REDUCE_WIDTH);
+        acc[v] = Select(x > acc[v], x, acc[v]);
+      }
+    }
+  } else {
+    /* Still independent chains, but no vectorization through the call */
+    for (; i + REDUCE_WIDTH <= n; i += REDUCE_WIDTH) {
+      for (int j = 0; j < REDUCE_WIDTH; j++) {
+        acc[0][j] = op->combine(acc[0][j], a[i + j]);
+      }
+    }
+  }
+
+  double result = op->identity;
+  for (int v = 0; v < REDUCE_VECTORS; v++) {
+    for (int j = 0; j < REDUCE_WIDTH; j++) {
+      result = op->combine(result, acc[v][j]);
+    }
+  }
+  for (; i < n; i++) result = op->combine(result, a[i]);
+  return result;
+}
+
+/* Function:      reducer_init
+ * In args:       thread_count, op, numa_aware
+ * Out arg:       reducer
+ * Return value:  0 on success, -1 if thread_count < 1 or allocation fails
+ */
+int reducer_init(reducer_t* reducer, int thread_count, const reduce_op_t* op,
+                 int numa_aware) {
+  if (thread_count < 1) return -1;
+  reducer->thread_count = thread_count;
+  reducer->numa_aware = numa_aware;
+  reducer->op = op;
+  reducer->slots =
+      aligned_alloc(REDUCE_CACHE_LINE, thread_count * sizeof(reduce_slot_t));
+  reducer->order = malloc(thread_count * sizeof(int));
+  reducer->position = malloc(thread_count * sizeof(int));
+  if (reducer->slots == NULL || reducer->order == NULL ||
+      reducer->position == NULL) {
+    reducer_destroy(reducer);
+    return -1;
+  }
+  for (int r = 0; r < thread_count; r++) {
+    reducer->order[r] = r;
+    reducer->position[r] = r;
+  }
+  pthread_barrier_init(&reducer->barrier, NULL, thread_count);
+  return 0;
+}
+
+void reducer_destroy(reducer_t* reducer) {
+  if (reducer->slots != NULL && reducer->order != NULL &&
+      reducer->position != NULL) {
+    pthread_barrier_destroy(&reducer->barrier);
+  }
+  free(reducer->slots);
+  free(reducer->order);
+  free(reducer->position);
+  reducer->slots = NULL;
+  reducer->order = reducer->position = NULL;
+}
+
+/* Orders the ranks by the node in their slot, keeping rank order within a
+ * node; a stable insertion sort, done by one thread */
+static void Order_by_node(reducer_t* reducer) {
+  int n = reducer->thread_count;
+  int* order = reducer->order;
+
+  for (int r = 0; r < n; r++) {
+    int node = reducer->slots[r].node;
+    int p = r;
+    while (p > 0 && reducer->slots[order[p - 1]].node > node) {
+      order[p] = order[p - 1];
+      p--;
+    }
+    order[p] = r;
+  }
+  for (int p = 0; p < n; p++) reducer->position[order[p]] = p;
+}
+
+/* Function:      reducer_combine
+ * In args:       rank (0 ... thread_count-1), value
+ * In/out arg:    reducer
+ * Return value:  the reduction of the values of all threads
+ * Purpose:       Every thread of the team must call it with its value
+ */
+double reducer_combine(reducer_t* reducer, long rank, double value) {
+  int n = reducer->thread_count;
+  reduce_slot_t* slots = reducer->slots;
+
+  slots[rank].value = value;
+  if (reducer->numa_aware) {
+    unsigned cpu, node = 0;
+    syscall(SYS_getcpu, &cpu, &node, NULL);
+    slots[rank].node = (int)node;
+    pthread_barrier_wait(&reducer->barrier);
+    if (rank == 0) Order_by_node(reducer);
+  }
+
+  int p = reducer->position[rank];
+  for (int stride = 1; stride < n; stride *= 2) {
+    pthread_barrier_wait(&reducer->barrier);
+    /* Read position after the barrier: rank 0 may just have reordered */
+    p = reducer->position[rank];
+    if (p % (2 * stride) == 0 && p + stride < n) {
+      int partner = reducer->order[p + stride];
+      slots[rank].value =
+          reducer->op->combine(slots[rank].value, slots[partner].value);
+    }
+  }
+  if (p == 0) reducer->result = slots[rank].value;
+  pthread_barrier_wait(&reducer->barrier);
+  return reducer->result;
+}
+
+static void* Reduce_work(void* arg) {
+  reduce_arg_t* my_arg = arg;
+  size_t quotient = my_arg->n / my_arg->thread_count;
+  size_t remainder = my_arg->n % my_arg->thread_count;
+  size_t first, count;
+
+  if ((size_t)my_arg->rank < remainder) {
+    count = quotient + 1;
+    first = my_arg->rank * count;
+  } else {
+    count = quotient;
+    first = my_arg->rank * quotient + remainder;
+  }
+
+  double local = reduce_local(my_arg->a + first, count, my_arg->reducer->op);
+  my_arg->result = reducer_combine(my_arg->reducer, my_arg->rank, local);
+  return NULL;
+}
+
+/* Function:      reduce_parallel
+ * In args:       a, n, thread_count, op, numa_aware
+ * Return value:  op applied over a[0 ... n-1]
+ * Purpose:       Split a into one contiguous block per thread, reduce the
+ *                blocks with reduce_local and combine them with a reducer
+ */
+double reduce_parallel(const double* a, size_t n, int thread_count,
+                       const reduce_op_t* op, int numa_aware) {
+  reducer_t reducer;
+  if (reducer_init(&reducer, thread_count, op, numa_aware) != 0) {
+    return reduce_local(a, n, op);
+  }
+
+  pthread_t* thread_handles = malloc(thread_count * sizeof(pthread_t));
+  reduce_arg_t* args = malloc(thread_count * sizeof(reduce_arg_t));
+  for (long thread = 0; thread < thread_count; thread++) {
+    args[thread] = (reduce_arg_t){a, n, thread_count, &reducer, thread, 0.0};
+    pthread_create(&thread_handles[thread], NULL, Reduce_work, &args[thread]);
+  }
+  for (long thread = 0; thread < thread_count; thread++) {
+    pthread_join(thread_handles[thread], NULL);
+  }
+
+  double result = args[0].result;
+  reducer_destroy(&reducer);
+  free(thread_handles);
+  free(args);
+  return result;
+}
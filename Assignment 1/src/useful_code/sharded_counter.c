@@ -0,0 +1,78 @@
+/* File:     sharded_counter.c
+ *
+ * Purpose:  implement the sharded counter of sharded_counter.h
+ *
+ * sc_init, sc_destroy:  allocate / free the slots
+ * sc_read:              sum of the slots, possibly mixing moments
+ * sc_sum:               exact value of the counter at one moment
+ *
+ * Notes:
+ * 1.  sc_read reads each slot once.  While adds are in flight the result
+ *     is only approximate: every slot is read at a different time, so the
+ *     sum may never have been the value of the counter.
+ * 2.  sc_sum repeats the collect until two consecutive collects agree.
+ *     The slots only grow, so equal collects mean nothing changed between
+ *     them and the sum is the counter's value at the moment the first
+ *     collect ended.  For the same reason no slot can be lower in the
+ *     second collect, so the collects agree exactly when their sums do,
+ *     and only the sums are kept.  It may retry for as long as adds keep
+ *     arriving.
+ */
+#include "sharded_counter.h"
+
+#include <stdlib.h>
+
+/* Function:      sc_init
+ * In arg:        slot_count
+ * Out arg:       counter
+ * Return value:  0 on success, -1 if slot_count < 1 or allocation fails
+ */
+int sc_init(sharded_counter_t* counter, int slot_count) {
+  if (slot_count < 1) return -1;
+  counter->slots = aligned_alloc(SC_SLOT_SIZE, slot_count * sizeof(sc_slot_t));
+  if (counter->slots == NULL) return -1;
+  counter->slot_count = slot_count;
+  for (int i = 0; i < slot_count; i++) atomic_init(&counter->slots[i].value, 0);
+  return 0;
+}
+
+void sc_destroy(sharded_counter_t* counter) {
+  free(counter->slots);
+  counter->slots = NULL;
+}
+
+/* Function:      sc_read
+ * In arg:        counter
+ * Return value:  sum of the slots, each read once
+ */
+unsigned long long sc_read(sharded_counter_t* counter) {
+  unsigned long long sum = 0;
+  for (int i = 0; i < counter->slot_count; i++) {
+    sum += atomic_load_explicit(&counter->slots[i].value, memory_order_relaxed);
+  }
+  return sum;
+}
+
+/* Sum of the slots, each read once with acquire */
+static unsigned long long Collect(sharded_counter_t* counter) {
+  unsigned long long sum = 0;
+  for (int i = 0; i < counter->slot_count; i++) {
+    sum += atomic_load_explicit(&counter->slots[i].value, memory_order_acquire);
+  }
+  return sum;
+}
+
+/* Function:      sc_sum
+ * In arg:        counter
+ * Return value:  value of the counter at a single moment during the call
+ */
+unsigned long long sc_sum(sharded_counter_t* counter) {
+  unsigned long long previous, sum = Collect(counter);
+
+  do {
+    /* The second collect is the first of the next round */
+    previous = sum;
+    sum = Collect(counter);
+  } while (sum != previous);
+  return sum;
+}
@@ -0,0 +1,128 @@
+/* File:     sobol.c
+ *
+ * Purpose:  generate the Sobol low-discrepancy sequence
+ *
+ * sobol_init:  set up the direction numbers and jump to a start index
+ * sobol_next:  the next point, as doubles in [0, 1)^dim; there are
+ *              2^SOBOL_BITS of them
+ * sobol_fill:  the next n points, stored point after point
+ *
+ * Notes:
+ * 1.  The direction numbers are those of S. Joe and F. Y. Kuo,
+ *     "Constructing Sobol sequences with better two-dimensional
+ *     projections" (new-joe-kuo-6.21201); the first dimension is the
+ *     van der Corput sequence in base 2.
+ * 2.  Point n is the XOR of the direction numbers selected by the bits of
+ *     the Gray code n ^ (n >> 1).  Going from n to n + 1 flips a single
+ *     bit of the Gray code, the lowest zero bit of n, so each new point
+ *     costs one XOR per coordinate (Antonov and Saleev).
+ * 3.  The main function prints the first points, compile with -D_MAIN_.
+ */
+#include "sobol.h"
+
+#include <stdio.h>
+
+#define SOBOL_SCALE (1.0 / 4294967296.0) /* 2^-32 */
+
+/* Degree s, coefficients a and initial numbers m_1 ... m_s of the
+ * primitive polynomial of dimensions 2 ... SOBOL_MAX_DIM */
+static const struct {
+  int s;
+  unsigned a;
+  unsigned m[5];
+} sobol_poly[SOBOL_MAX_DIM - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+};
+
+#ifdef _MAIN_
+int main(void) {
+  sobol_t sobol;
+  double point[SOBOL_MAX_DIM];
+
+  sobol_init(&sobol, 3, 0);
+  for (int i = 0; i < 8; i++) {
+    sobol_next(&sobol, point);
+    printf("%f %f %f\n", point[0], point[1], point[2]);
+  }
+  return 0;
+}
+#endif
+
+/* Function:      sobol_init
+ * In args:       dim, start
+ * Out arg:       sobol
+ * Return value:  0 on success, -1 if dim is not in 1 ... SOBOL_MAX_DIM
+ * Purpose:       Compute the direction numbers and position the generator
+ *                at point start, building the point from the bits of the
+ *                Gray code of start instead of stepping to it
+ */
+int sobol_init(sobol_t* sobol, int dim, unsigned long long start) {
+  if (dim < 1 || dim > SOBOL_MAX_DIM) return -1;
+  sobol->dim = dim;
+
+  for (int k = 0; k < SOBOL_BITS; k++) {
+    sobol->v[0][k] = 1U << (SOBOL_BITS - 1 - k);
+  }
+
+  for (int d = 1; d < dim; d++) {
+    int s = sobol_poly[d - 1].s;
+    unsigned a = sobol_poly[d - 1].a;
+    uint32_t* v = sobol->v[d];
+
+    for (int k = 0; k < s && k < SOBOL_BITS; k++) {
+      v[k] = sobol_poly[d - 1].m[k] << (SOBOL_BITS - 1 - k);
+    }
+    for (int k = s; k < SOBOL_BITS; k++) {
+      v[k] = v[k - s] ^ (v[k - s] >> s);
+      for (int i = 1; i < s; i++) {
+        if ((a >> (s - 1 - i)) & 1) v[k] ^= v[k - i];
+      }
+    }
+  }
+
+  unsigned long long gray = start ^ (start >> 1);
+  for (int d = 0; d < dim; d++) {
+    sobol->x[d] = 0;
+    for (int k = 0; k < SOBOL_BITS; k++) {
+      if ((gray >> k) & 1) sobol->x[d] ^= sobol->v[d][k];
+    }
+  }
+  sobol->index = start;
+  return 0;
+}
+
+/* Function:   sobol_next
+ * In/out arg: sobol
+ * Out arg:    point (sobol->dim coordinates)
+ * Purpose:    Return the current point and step to the next index
+ */
+void sobol_next(sobol_t* sobol, double* point) {
+  int c = __builtin_ctzll(~sobol->index);
+
+  /* Point 2^SOBOL_BITS - 1 is the last one; there is no v[d][SOBOL_BITS]
+   * to step past it with */
+  for (int d = 0; d < sobol->dim; d++) {
+    point[d] = sobol->x[d] * SOBOL_SCALE;
+    if (c < SOBOL_BITS) sobol->x[d] ^= sobol->v[d][c];
+  }
+  sobol->index++;
+}
+
+/* Function:   sobol_fill
+ * In/out arg: sobol
+ * Out arg:    points (n * sobol->dim doubles)
+ * In arg:     n
+ */
+void sobol_fill(sobol_t* sobol, double* points, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    sobol_next(sobol, points + i * sobol->dim);
+  }
+}
@@ -0,0 +1,397 @@
+/* File:     workload.c
+ *
+ * Purpose:  parse workload specs for the list benchmarks and generate
+ *           their operations and keys
+ *
+ * wl_load:      parse a spec given as a string or as the name of a file
+ * wl_free:      release what wl_load allocated
+ * wl_print:     print the parsed phases
+ * wl_gen_init:  set up the generator state of one thread
+ * wl_next:      the next operation and key of a thread in a phase (the
+ *               first key of the range for a scan)
+ *
+ * Notes:
+ * 1.  The spec syntax is described in workload.h.
+ * 2.  Zipf ranks are drawn with the method of Gray et al. ("Quickly
+ *     generating billion-record synthetic databases", SIGMOD 1994), as in
+ *     YCSB.  Its normalisation constant zeta(n, theta) is summed exactly
+ *     for the first WL_ZETA_EXACT terms and approximated by an integral
+ *     for the rest, so large key ranges cost no more than 2^20 terms.
+ * 3.  Zipf and hotspot ranks are mapped to keys by multiplying with the
+ *     prime WL_SCRAMBLE modulo the key range, which is a bijection unless
+ *     the range is a multiple of it.
+ * 4.  Thread rank's sequential keys are rank, rank + thread_count, ...
+ *     modulo the key range, so together the threads sweep it in order.
+ */
+#include "workload.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "my_rand.h"
+
+#define WL_ZETA_EXACT (1 << 20)
+#define WL_SCRAMBLE 2654435761ULL
+#define WL_MIX_TOLERANCE 1e-9
+
+static const char* const OP_NAMES[WL_OP_COUNT] = {"member", "insert",
+                                                  "delete", "scan"};
+static const char* const DIST_NAMES[] = {"uniform", "zipf", "hotspot",
+                                         "sequential"};
+
+/* Returns the spec text: the contents of the file spec if there is one,
+ * else a copy of spec */
+static char* Read_spec(const char* spec) {
+  FILE* file = fopen(spec, "r");
+  if (file == NULL) return strdup(spec);
+
+  size_t length = 0, capacity = 4096;
+  char* text = malloc(capacity);
+  size_t n;
+  while (text != NULL &&
+         (n = fread(text + length, 1, capacity - length - 1, file)) > 0) {
+    length += n;
+    if (capacity - length == 1) {
+      capacity *= 2;
+      char* bigger = realloc(text, capacity);
+      if (bigger == NULL) free(text);
+      text = bigger;
+    }
+  }
+  fclose(file);
+  if (text != NULL) text[length] = '\0';
+  return text;
+}
+
+static int Parse_double(const char* name, const char* value, double* out) {
+  char* end;
+  *out = strtod(value, &end);
+  if (end == value || *end != '\0') {
+    fprintf(stderr, "Workload: bad value '%s' for %s.\n", value, name);
+    return -1;
+  }
+  return 0;
+}
+
+static int Parse_count(const char* name, const char* value, long long* out) {
+  char* end;
+  *out = strtoll(value, &end, 10);
+  if (end == value || *end != '\0' || *out < 0) {
+    fprintf(stderr, "Workload: bad value '%s' for %s.\n", value, name);
+    return -1;
+  }
+  return 0;
+}
+
+/* Parses name[:a[:b]] of dist= into phase */
+static int Parse_dist(char* value, wl_phase_t* phase) {
+  char* arg = strchr(value, ':');
+  char* arg2 = NULL;
+
+  if (arg != NULL) {
+    *arg++ = '\0';
+    arg2 = strchr(arg, ':');
+    if (arg2 != NULL) *arg2++ = '\0';
+  }
+  if (strcmp(value, "uniform") == 0 && arg == NULL) {
+    phase->dist = WL_UNIFORM;
+  } else if (strcmp(value, "sequential") == 0 && arg == NULL) {
+    phase->dist = WL_SEQUENTIAL;
+  } else if (strcmp(value, "zipf") == 0 && arg2 == NULL) {
+    phase->dist = WL_ZIPF;
+    phase->theta = 0.99;
+    if (arg != NULL && Parse_double("zipf theta", arg, &phase->theta) != 0) {
+      return -1;
+    }
+    if (!(phase->theta > 0.0 && phase->theta < 1.0)) {
+      fprintf(stderr, "Workload: zipf theta must be in (0, 1).\n");
+      return -1;
+    }
+  } else if (strcmp(value, "hotspot") == 0) {
+    phase->dist = WL_HOTSPOT;
+    phase->hot_keys = 0.2;
+    phase->hot_ops = 0.8;
+    if ((arg != NULL &&
+         Parse_double("hotspot keys", arg, &phase->hot_keys) != 0) ||
+        (arg2 != NULL &&
+         Parse_double("hotspot ops", arg2, &phase->hot_ops) != 0)) {
+      return -1;
+    }
+    if (!(phase->hot_keys > 0.0 && phase->hot_keys < 1.0) ||
+        !(phase->hot_ops >= 0.0 && phase->hot_ops <= 1.0)) {
+      fprintf(stderr,
+              "Workload: hotspot needs keys fraction in (0, 1), ops "
+              "fraction in [0, 1].\n");
+      return -1;
+    }
+  } else {
+    fprintf(stderr, "Workload: unknown distribution '%s'.\n", value);
+    return -1;
+  }
+  return 0;
+}
+
+/* Parses one ';' or newline separated segment.  Settings of the whole run
+ * go to wl; a segment with ops= or time= adds a phase built on *current.
+ */
+static int Parse_segment(workload_t* wl, char* segment, wl_phase_t* current) {
+  int has_member = 0, has_insert = 0, has_delete = 0, has_phase = 0;
+  double delete = 0.0;
+  char* save;
+
+  current->ops = 0;
+  current->seconds = 0.0;
+  for (char* token = strtok_r(segment, " \t\r,", &save); token != NULL;
+       token = strtok_r(NULL, " \t\r,", &save)) {
+    char* value = strchr(token, '=');
+    if (value == NULL) {
+      fprintf(stderr, "Workload: expected name=value, got '%s'.\n", token);
+      return -1;
+    }
+    *value++ = '\0';
+    int rv;
+    if (strcmp(token, "init") == 0) {
+      rv = Parse_count(token, value, &wl->init);
+    } else if (strcmp(token, "keys") == 0) {
+      rv = Parse_count(token, value, &wl->keys);
+    } else if (strcmp(token, "member") == 0) {
+      rv = Parse_double(token, value, &current->member);
+      has_member = has_phase = 1;
+    } else if (strcmp(token, "insert") == 0) {
+      rv = Parse_double(token, value, &current->insert);
+      has_insert = has_phase = 1;
+    } else if (strcmp(token, "delete") == 0) {
+      rv = Parse_double(token, value, &delete);
+      has_delete = has_phase = 1;
+    } else if (strcmp(token, "scan") == 0) {
+      rv = Parse_double(token, value, &current->scan);
+      has_phase = 1;
+    } else if (strcmp(token, "range") == 0) {
+      rv = Parse_count(token, value, &current->range);
+      has_phase = 1;
+    } else if (strcmp(token, "dist") == 0) {
+      rv = Parse_dist(value, current);
+      has_phase = 1;
+    } else if (strcmp(token, "ops") == 0) {
+      rv = Parse_count(token, value, &current->ops);
+      has_phase = 1;
+    } else if (strcmp(token, "time") == 0) {
+      rv = Parse_double(token, value, &current->seconds);
+      has_phase = 1;
+    } else {
+      fprintf(stderr, "Workload: unknown setting '%s'.\n", token);
+      return -1;
+    }
+    if (rv != 0) return -1;
+  }
+  if (!has_phase) return 0;
+
+  if ((current->ops > 0) == (current->seconds > 0.0)) {
+    fprintf(stderr, "Workload: every phase needs either ops= or time=.\n");
+    return -1;
+  }
+  if (has_delete && !has_insert) {
+    current->insert = 1.0 - current->member - current->scan - delete;
+  } else if (has_delete && !has_member) {
+    current->member = 1.0 - current->insert - current->scan - delete;
+  } else if (has_delete &&
+             fabs(current->member + current->insert + current->scan + delete -
+                  1.0) > WL_MIX_TOLERANCE) {
+    fprintf(stderr,
+            "Workload: member + insert + scan + delete must be 1.\n");
+    return -1;
+  }
+  if (current->member < -WL_MIX_TOLERANCE ||
+      current->insert < -WL_MIX_TOLERANCE ||
+      current->scan < -WL_MIX_TOLERANCE ||
+      current->member + current->insert + current->scan >
+          1.0 + WL_MIX_TOLERANCE) {
+    fprintf(stderr,
+            "Workload: op fractions must be in [0, 1] and sum to 1.\n");
+    return -1;
+  }
+  if (current->range < 1 || current->range > INT_MAX) {
+    fprintf(stderr, "Workload: range must be in 1 ... %d.\n", INT_MAX);
+    return -1;
+  }
+
+  wl_phase_t* phases =
+      realloc(wl->phases, (wl->phase_count + 1) * sizeof(wl_phase_t));
+  if (phases == NULL) {
+    fprintf(stderr, "Workload: out of memory.\n");
+    return -1;
+  }
+  wl->phases = phases;
+  wl->phases[wl->phase_count++] = *current;
+  return 0;
+}
+
+static double Zeta(long long n, double theta) {
+  long long exact = n < WL_ZETA_EXACT ? n : WL_ZETA_EXACT;
+  double sum = 0.0;
+
+  for (long long i = 1; i <= exact; i++) sum += pow((double)i, -theta);
+  if (n > exact) {
+    sum += (pow(n + 0.5, 1.0 - theta) - pow(exact + 0.5, 1.0 - theta)) /
+           (1.0 - theta);
+  }
+  return sum;
+}
+
+/* Function:      wl_load
+ * Purpose:       Parse a workload spec
+ * In args:       spec (the spec itself, or the name of a file holding it),
+ *                default_keys (key range unless the spec sets keys=)
+ * Out arg:       wl
+ * Return value:  0 on success, -1 after printing an error to stderr
+ */
+int wl_load(workload_t* wl, const char* spec, long long default_keys) {
+  wl_phase_t current = {1.0, 0.0, 0.0, 100, 0, 0.0, WL_UNIFORM, 0.99,
+                        0.2, 0.8, 0.0, 0.0, 0.0};
+  char* text = Read_spec(spec);
+  char* save;
+
+  wl->init = 0;
+  wl->keys = default_keys;
+  wl->phase_count = 0;
+  wl->phases = NULL;
+  if (text == NULL) {
+    fprintf(stderr, "Workload: out of memory.\n");
+    return -1;
+  }
+
+  /* Blank out comments */
+  for (char* c = strchr(text, '#'); c != NULL; c = strchr(c, '#')) {
+    while (*c != '\0' && *c != '\n') *c++ = ' ';
+  }
+
+  for (char* segment = strtok_r(text, ";\n", &save); segment != NULL;
+       segment = strtok_r(NULL, ";\n", &save)) {
+    if (Parse_segment(wl, segment, &current) != 0) goto fail;
+  }
+  free(text);
+  text = NULL;
+
+  if (wl->phase_count == 0) {
+    fprintf(stderr, "Workload: no phases (a phase needs ops= or time=).\n");
+    goto fail;
+  }
+  /* Keys stay below INT_MAX, which some backends use as a sentinel */
+  if (wl->keys < 1 || wl->keys > INT_MAX) {
+    fprintf(stderr, "Workload: keys must be in 1 ... %d.\n", INT_MAX);
+    goto fail;
+  }
+  if (wl->init > wl->keys) {
+    fprintf(stderr, "Workload: init cannot exceed keys.\n");
+    goto fail;
+  }
+
+  for (int p = 0; p < wl->phase_count; p++) {
+    wl_phase_t* phase = &wl->phases[p];
+    if (phase->dist != WL_ZIPF) continue;
+    double theta = phase->theta;
+    phase->zeta_n = Zeta(wl->keys, theta);
+    phase->alpha = 1.0 / (1.0 - theta);
+    phase->eta = (1.0 - pow(2.0 / wl->keys, 1.0 - theta)) /
+                 (1.0 - Zeta(2, theta) / phase->zeta_n);
+  }
+  return 0;
+
+fail:
+  free(text);
+  wl_free(wl);
+  return -1;
+}
+
+void wl_free(workload_t* wl) {
+  free(wl->phases);
+  wl->phases = NULL;
+  wl->phase_count = 0;
+}
+
+void wl_print(const workload_t* wl) {
+  printf("Workload: %lld initial keys out of %lld\n", wl->init, wl->keys);
+  for (int p = 0; p < wl->phase_count; p++) {
+    const wl_phase_t* phase = &wl->phases[p];
+    printf("  Phase %d: member %.3f insert %.3f delete %.3f", p,
+           phase->member, phase->insert,
+           1.0 - phase->member - phase->insert - phase->scan);
+    if (phase->scan > 0.0) {
+      printf(" scan %.3f of %lld keys", phase->scan, phase->range);
+    }
+    printf(", %s", DIST_NAMES[phase->dist]);
+    if (phase->dist == WL_ZIPF) printf(" theta %.3f", phase->theta);
+    if (phase->dist == WL_HOTSPOT) {
+      printf(" %.3f of keys get %.3f of ops", phase->hot_keys, phase->hot_ops);
+    }
+    if (phase->ops > 0) {
+      printf(", %lld ops\n", phase->ops);
+    } else {
+      printf(", %.3f seconds\n", phase->seconds);
+    }
+  }
+}
+
+void wl_gen_init(wl_gen_t* gen, unsigned seed, long rank, int thread_count) {
+  gen->seed = seed;
+  gen->next = rank;
+  gen->stride = thread_count;
+}
+
+static long long Zipf_rank(const wl_phase_t* phase, long long n, double u) {
+  double uz = u * phase->zeta_n;
+
+  if (uz < 1.0) return 0;
+  if (uz < 1.0 + pow(0.5, phase->theta)) return 1;
+  long long rank =
+      (long long)(n * pow(phase->eta * u - phase->eta + 1.0, phase->alpha));
+  return rank < n ? rank : n - 1;
+}
+
+/* Function:      wl_next
+ * In args:       wl, phase
+ * In/out arg:    gen (state of the calling thread)
+ * Out arg:       key
+ * Return value:  the operation to run on key
+ */
+wl_op_t wl_next(const workload_t* wl, int phase, wl_gen_t* gen, int* key) {
+  const wl_phase_t* p = &wl->phases[phase];
+  double which_op = my_drand(&gen->seed);
+  unsigned long long rank;
+
+  switch (p->dist) {
+    case WL_UNIFORM:
+      rank = my_rand(&gen->seed) % wl->keys;
+      break;
+    case WL_ZIPF:
+      rank = Zipf_rank(p, wl->keys, my_drand(&gen->seed));
+      rank = rank * WL_SCRAMBLE % wl->keys;
+      break;
+    case WL_HOTSPOT: {
+      long long hot = (long long)(p->hot_keys * wl->keys);
+      if (hot < 1) hot = 1;
+      if (my_drand(&gen->seed) < p->hot_ops || hot == wl->keys) {
+        rank = (long long)(my_drand(&gen->seed) * hot);
+      } else {
+        rank = hot + (long long)(my_drand(&gen->seed) * (wl->keys - hot));
+      }
+      rank = rank * WL_SCRAMBLE % wl->keys;
+      break;
+    }
+    default: /* WL_SEQUENTIAL */
+      rank = gen->next % wl->keys;
+      gen->next += gen->stride;
+      break;
+  }
+  *key = (int)rank;
+
+  if (which_op < p->member) return WL_MEMBER;
+  if (which_op < p->member + p->insert) return WL_INSERT;
+  if (which_op < p->member + p->insert + p->scan) return WL_SCAN;
+  return WL_DELETE;
+}
+
+const char* wl_op_name(wl_op_t op) { return OP_NAMES[op]; }